@@ -0,0 +1,75 @@
+#include "bandprefetcher.h"
+
+#include <QThread>
+#include <QMutexLocker>
+#include <stdexcept>
+
+BandPrefetcher::BandPrefetcher(const QList<Request>& requests, int depth, int inFlight)
+    : requests(requests)
+    , ring(qMax(1, depth) + qMax(0, inFlight))
+    , depth(qMax(1, depth))
+{}
+
+BandPrefetcher::~BandPrefetcher()
+{
+    if (!readerThread) return;
+    {
+        QMutexLocker locker(&mutex);
+        stopRequested = true;
+        slotReleased.wakeAll();
+    }
+    readerThread->wait();
+    delete readerThread;
+}
+
+void BandPrefetcher::start()
+{
+    if (readerThread) return;
+    readerThread = QThread::create([this]() { readLoop(); });
+    readerThread->start();
+}
+
+QList<QByteArray> BandPrefetcher::take()
+{
+    QMutexLocker locker(&mutex);
+    while (takenCount >= readCount && !readFailed) blockRead.wait(&mutex);
+    if (takenCount >= readCount) throw std::runtime_error("读取预处理后的临时文件失败。");
+
+    // 浅拷贝：数据仍与槽共享，直到读取线程复用该槽时才分离
+    const QList<QByteArray> blocks = ring.at(takenCount % ring.size());
+    ++takenCount;
+    slotReleased.wakeAll();
+    return blocks;
+}
+
+void BandPrefetcher::readLoop()
+{
+    for (int i = 0; i < requests.size(); ++i) {
+        {
+            // 已提前读取depth个条带时等待合成线程取走最早的条带
+            QMutexLocker locker(&mutex);
+            while (!stopRequested && i - takenCount >= depth) slotReleased.wait(&mutex);
+            if (stopRequested) return;
+        }
+
+        // 该槽此时只属于读取线程，在锁外读盘
+        const Request& request = requests[i];
+        QList<QByteArray>& buffers = ring[i % ring.size()];
+        buffers.resize(request.frameFiles.size() * request.blockCount);
+        bool ok = true;
+        for (int f = 0; ok && f < request.frameFiles.size(); ++f) {
+            for (int j = 0; ok && j < request.blockCount; ++j) {
+                ok = request.frameFiles[f]->readBlock(request.firstBlock + j, buffers[f * request.blockCount + j]);
+            }
+        }
+
+        QMutexLocker locker(&mutex);
+        if (!ok) {
+            readFailed = true;
+            blockRead.wakeAll();
+            return;
+        }
+        readCount = i + 1;
+        blockRead.wakeAll();
+    }
+}
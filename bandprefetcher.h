@@ -0,0 +1,71 @@
+#ifndef BANDPREFETCHER_H
+#define BANDPREFETCHER_H
+
+#include "scratchframe.h"
+
+#include <QList>
+#include <QByteArray>
+#include <QMutex>
+#include <QWaitCondition>
+
+class QThread;
+
+/**
+ * @class BandPrefetcher
+ * @brief 阶段二的预读线程：按合成的提交顺序，提前读取后续条带在各帧临时文件中的块。
+ *
+ * 读取结果放在一个固定槽数的环形缓冲区中，合成线程取走当前条带时，读取线程已在读下一个条带，
+ * 磁盘读取与合成互相重叠。环形缓冲区除预读的槽外，还为取走后仍在合成的条带留出槽，
+ * 一个槽再次被读取时，上一轮的数据已经合成完毕，缓冲区的内存直接复用。即使仍被引用，
+ * QByteArray的隐式共享也会让读取线程自动改用新的缓冲区，不会覆盖正在使用的数据。
+ */
+class BandPrefetcher
+{
+public:
+    /// @brief 一个条带的读取请求：需要读取的各帧临时文件，以及每帧从firstBlock开始的连续blockCount个块。
+    struct Request {
+        QList<ScratchFrameFile*> frameFiles;
+        int firstBlock = 0;
+        int blockCount = 1;
+    };
+
+    /**
+     * @brief 构造预读器。请求中的临时文件在预读器存在期间只能由读取线程访问。
+     * @param requests 按提交顺序排列的全部读取请求。
+     * @param depth 最多提前读取的条带数。
+     * @param inFlight 取走后最多同时仍在合成的条带数，环形缓冲区共有depth + inFlight个槽。
+     */
+    BandPrefetcher(const QList<Request>& requests, int depth, int inFlight = 0);
+
+    /**
+     * @brief 析构时停止读取线程并等待其结束，可在任何时刻调用(包括取消和出错)。
+     */
+    ~BandPrefetcher();
+
+    /// @brief 启动读取线程。
+    void start();
+
+    /**
+     * @brief 按请求顺序取出下一个条带各帧的存储数据，尚未读完时等待。读取失败时抛出std::exception。
+     * @return 按帧排列，第f帧的第j块位于f * blockCount + j。
+     */
+    QList<QByteArray> take();
+
+private:
+    QList<Request> requests;
+    QList<QList<QByteArray>> ring;  ///< 环形缓冲区，第i个请求使用第i % ring.size()个槽
+    int depth;
+
+    QMutex mutex;
+    QWaitCondition blockRead;       ///< 读取线程读完一个请求
+    QWaitCondition slotReleased;    ///< 合成线程取走一个请求
+    int readCount = 0;              ///< 已读完的请求数
+    int takenCount = 0;             ///< 已取走的请求数
+    bool readFailed = false;
+    bool stopRequested = false;
+    QThread* readerThread = nullptr;
+
+    void readLoop();
+};
+
+#endif // BANDPREFETCHER_H
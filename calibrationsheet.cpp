@@ -0,0 +1,188 @@
+#include "calibrationsheet.h"
+
+#include <QPainter>
+#include <QImageReader>
+#include <QFont>
+#include <QRect>
+#include <QFuture>
+#include <QThread>
+#include <QtConcurrent/QtConcurrentMap>
+#include <stdexcept>
+#include <cmath>
+#include <cstring>
+
+CalibrationSheetRenderer::CalibrationSheetRenderer(const CalibrationSheetSettings& settings)
+    : settings(settings)
+{}
+
+int CalibrationSheetRenderer::requestedBandCount() const
+{
+    if (settings.lpiStep <= 0.0 || settings.endLpi < settings.startLpi) return 0;
+    return static_cast<int>(std::floor((settings.endLpi - settings.startLpi) / settings.lpiStep + 0.5)) + 1;
+}
+
+QList<double> CalibrationSheetRenderer::lpiValues() const
+{
+    QList<double> values;
+    const int count = qMin(requestedBandCount(), maxBandCount);
+    for (int i = 0; i < count; ++i) {
+        values.append(settings.startLpi + i * settings.lpiStep);
+    }
+    return values;
+}
+
+QSize CalibrationSheetRenderer::sheetPixelSize() const
+{
+    const double pixelsPerCm = settings.dpi / 2.54;
+    return QSize(static_cast<int>(std::round(settings.pageWidthCm * pixelsPerCm)),
+                 static_cast<int>(std::round(settings.pageHeightCm * pixelsPerCm)));
+}
+
+QImage CalibrationSheetRenderer::render(const LenticularRenderer::ProgressCallback& progress)
+{
+    const QList<double> lpis = lpiValues();
+    const int bandCount = lpis.size();
+    const int numFrames = settings.imagePaths.size();
+    const bool isVertical = settings.isVertical;
+    if (bandCount == 0 || numFrames == 0 || settings.dpi <= 0.0) {
+        throw std::runtime_error("校准参数无效，请检查LPI范围和步长。");
+    }
+
+    const QSize sheetSize = sheetPixelSize();
+    if (sheetSize.isEmpty()) throw std::runtime_error("测试页尺寸无效。");
+
+    // 条带沿垂直于光栅的方向堆叠；标注区留在条带一侧，条带之间留白分隔
+    const int labelExtent = qRound(settings.dpi * 0.6);
+    const int gap = qMax(1, qRound(settings.dpi * 0.04));
+    const int stackLength = isVertical ? sheetSize.height() : sheetSize.width();
+    const int crossLength = (isVertical ? sheetSize.width() : sheetSize.height()) - labelExtent;
+    const int bandThickness = (stackLength - gap * (bandCount - 1)) / bandCount;
+    if (bandThickness < 1 || crossLength < 1) {
+        throw std::runtime_error("页面太小，无法容纳这么多条带，请减小LPI范围或增大步长。");
+    }
+    const int bandPitch = bandThickness + gap;
+    const QSize bandSize = isVertical ? QSize(crossLength, bandThickness) : QSize(bandThickness, crossLength);
+
+    // --- 测试帧只解码、缩放一次，所有条带共享。停留多个切片位置的帧路径重复出现，每个不同的路径只解码一次 ---
+    QList<QString> uniquePaths;
+    QList<int> uniqueIndexOfFrame;
+    for (const QString& path : settings.imagePaths) {
+        qsizetype index = uniquePaths.indexOf(path);
+        if (index < 0) {
+            index = uniquePaths.size();
+            uniquePaths.append(path);
+        }
+        uniqueIndexOfFrame.append(static_cast<int>(index));
+    }
+    if (!progress(0, QString("正在准备测试帧 (共 %1 张)...").arg(uniquePaths.size()))) return QImage();
+    const QList<QImage> uniqueFrames = QtConcurrent::blockingMapped(uniquePaths, [bandSize](const QString& path) {
+        // 按EXIF方向摆正，与渲染时一致
+        QImageReader reader(path);
+        reader.setAutoTransform(true);
+        const QImage original = reader.read();
+        if (original.isNull()) return QImage();
+        // 保持比例铺满条带，再居中裁切
+        QImage filled = original.scaled(bandSize, Qt::KeepAspectRatioByExpanding, Qt::SmoothTransformation);
+        return filled.copy((filled.width() - bandSize.width()) / 2, (filled.height() - bandSize.height()) / 2,
+                           bandSize.width(), bandSize.height())
+                     .convertToFormat(QImage::Format_ARGB32);
+    });
+    QList<QImage> frames;
+    for (int index : uniqueIndexOfFrame) {
+        if (uniqueFrames[index].isNull()) throw std::runtime_error("无法加载或缩放测试帧。");
+        frames.append(uniqueFrames[index]);
+    }
+
+    // 每个条带的切片表：沿光栅间距方向的每个像素应取自哪一帧。
+    // 光栅单元宽 dpi/lpi 像素，其中依次排列 numFrames 个切片，切片宽度可以是小数
+    QList<QList<int>> sliceTables;
+    for (double lpi : lpis) {
+        const double slicesPerPixel = lpi * numFrames / settings.dpi;
+        QList<int> table(crossLength);
+        for (int i = 0; i < crossLength; ++i) {
+            table[i] = static_cast<int>(std::floor(i * slicesPerPixel)) % numFrames;
+        }
+        sliceTables.append(table);
+    }
+
+    QImage sheet(sheetSize, QImage::Format_ARGB32);
+    if (sheet.isNull()) throw std::bad_alloc();
+    sheet.fill(Qt::white);
+    uchar* sheetBits = sheet.bits();
+    const qsizetype sheetBytesPerLine = sheet.bytesPerLine();
+
+    // --- 整页一次并行合成，每个任务负责若干行 ---
+    const int rowsPerTask = 32;
+    QList<int> taskRows;
+    for (int y = 0; y < sheetSize.height(); y += rowsPerTask) taskRows.append(y);
+
+    auto compositeRows = [&](const int& firstRow) {
+        const int lastRow = qMin(firstRow + rowsPerTask, sheetSize.height());
+        for (int y = firstRow; y < lastRow; ++y) {
+            QRgb* sheetLine = reinterpret_cast<QRgb*>(sheetBits + y * sheetBytesPerLine);
+            if (isVertical) {
+                // 行落在哪个条带；落在间隔里的行保持白色
+                const int band = y / bandPitch;
+                const int localY = y % bandPitch;
+                if (band >= bandCount || localY >= bandThickness) continue;
+                const QList<int>& table = sliceTables[band];
+                QRgb* dst = sheetLine + labelExtent;
+                for (int x = 0; x < crossLength; ++x) {
+                    dst[x] = reinterpret_cast<const QRgb*>(frames[table[x]].constScanLine(localY))[x];
+                }
+            } else {
+                // 横向切分：每个条带内同一行取自同一帧，整段复制
+                const int localY = y - labelExtent;
+                if (localY < 0 || localY >= crossLength) continue;
+                for (int band = 0; band < bandCount; ++band) {
+                    const int frameIndex = sliceTables[band][localY];
+                    memcpy(sheetLine + band * bandPitch,
+                           frames[frameIndex].constScanLine(localY),
+                           bandThickness * sizeof(QRgb));
+                }
+            }
+        }
+    };
+
+    QFuture<void> future = QtConcurrent::map(taskRows, compositeRows);
+    while (!future.isFinished()) {
+        const int done = future.progressValue() - future.progressMinimum();
+        const int total = qMax(1, future.progressMaximum() - future.progressMinimum());
+        if (!progress(5 + done * 90 / total, QString("正在合成 %1 个校准条带...").arg(bandCount))) {
+            future.cancel();
+            future.waitForFinished();
+            return QImage();
+        }
+        QThread::msleep(20);
+    }
+
+    // --- 标注每个条带的LPI ---
+    QPainter painter(&sheet);
+    painter.setRenderHint(QPainter::TextAntialiasing);
+    painter.setPen(Qt::black);
+    QFont font;
+    font.setPixelSize(qMax(6, qMin(labelExtent / 4, bandThickness * 2 / 3)));
+    painter.setFont(font);
+    for (int band = 0; band < bandCount; ++band) {
+        const QString text = QString::number(lpis[band], 'f', 2);
+        if (isVertical) {
+            painter.drawText(QRect(0, band * bandPitch, labelExtent, bandThickness), Qt::AlignCenter, text);
+        } else {
+            // 标注竖排在每个条带上方
+            painter.save();
+            painter.translate(band * bandPitch + bandThickness / 2.0, labelExtent / 2.0);
+            painter.rotate(-90);
+            painter.drawText(QRect(-labelExtent / 2, -bandThickness / 2, labelExtent, bandThickness), Qt::AlignCenter, text);
+            painter.restore();
+        }
+    }
+    painter.end();
+
+    // 写入物理分辨率，保证按原尺寸打印
+    const int dotsPerMeter = qRound(settings.dpi / 0.0254);
+    sheet.setDotsPerMeterX(dotsPerMeter);
+    sheet.setDotsPerMeterY(dotsPerMeter);
+
+    progress(100, QString("正在合成 %1 个校准条带...").arg(bandCount));
+    return sheet;
+}
@@ -0,0 +1,65 @@
+#ifndef CALIBRATIONSHEET_H
+#define CALIBRATIONSHEET_H
+
+#include "lenticularrenderer.h"
+
+#include <QList>
+#include <QString>
+#include <QSize>
+#include <QImage>
+
+/**
+ * @struct CalibrationSheetSettings
+ * @brief LPI校准测试页的生成参数。
+ */
+struct CalibrationSheetSettings {
+    QList<QString> imagePaths;  ///< 测试帧的路径
+    bool isVertical = true;     ///< 是否为纵向切分
+    double pageWidthCm = 21.0;  ///< 页面物理宽度(厘米)
+    double pageHeightCm = 29.7; ///< 页面物理高度(厘米)
+    double dpi = 600.0;         ///< 测试页的打印分辨率
+    double startLpi = 89.0;     ///< 第一个条带的LPI
+    double endLpi = 91.0;       ///< 最后一个条带的LPI
+    double lpiStep = 0.1;       ///< 相邻条带的LPI差值
+};
+
+/**
+ * @class CalibrationSheetRenderer
+ * @brief 在一张页面上生成多个不同LPI的交织条带，用于一次性测出打印机的校准LPI。
+ *
+ * 每个测试帧只解码、缩放一次，所有条带共享；整页在线程池中一次并行合成。
+ */
+class CalibrationSheetRenderer
+{
+public:
+    /// @brief 测试页最多容纳的条带数量
+    static constexpr int maxBandCount = 60;
+
+    explicit CalibrationSheetRenderer(const CalibrationSheetSettings& settings);
+
+    /**
+     * @brief 起止LPI和步长覆盖的条带数量，不受maxBandCount限制；参数无效时返回0。
+     */
+    int requestedBandCount() const;
+
+    /**
+     * @brief 根据起止LPI和步长，列出每个条带对应的LPI。超过maxBandCount的部分被截去。
+     */
+    QList<double> lpiValues() const;
+
+    /**
+     * @brief 测试页的像素尺寸。
+     */
+    QSize sheetPixelSize() const;
+
+    /**
+     * @brief 生成整张测试页。
+     * @return 生成的测试页，被取消时返回空图像。出错时抛出std::exception。
+     */
+    QImage render(const LenticularRenderer::ProgressCallback& progress);
+
+private:
+    CalibrationSheetSettings settings;
+};
+
+#endif // CALIBRATIONSHEET_H
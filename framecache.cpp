@@ -0,0 +1,62 @@
+#include "framecache.h"
+
+#include <QFileInfo>
+#include <QDateTime>
+#include <QMutexLocker>
+
+FrameCache::FrameCache(int capacityMb)
+    : images(qMax(1, capacityMb) * 1024)
+{}
+
+QString FrameCache::sourceKey(const QString& path)
+{
+    const QFileInfo info(path);
+    if (!info.exists()) return QString();
+    return QString("%1|%2|%3").arg(info.absoluteFilePath())
+                              .arg(info.size())
+                              .arg(info.lastModified().toMSecsSinceEpoch());
+}
+
+QImage FrameCache::decodedFrame(const QString& sourceKey)
+{
+    return lookup(sourceKey);
+}
+
+QImage FrameCache::scaledFrame(const QString& sourceKey, const QSize& size)
+{
+    return lookup(QString("%1|%2x%3").arg(sourceKey).arg(size.width()).arg(size.height()));
+}
+
+void FrameCache::insertDecodedFrame(const QString& sourceKey, const QImage& image)
+{
+    insert(sourceKey, image);
+}
+
+void FrameCache::insertScaledFrame(const QString& sourceKey, const QSize& size, const QImage& image)
+{
+    insert(QString("%1|%2x%3").arg(sourceKey).arg(size.width()).arg(size.height()), image);
+}
+
+void FrameCache::clear()
+{
+    QMutexLocker locker(&mutex);
+    images.clear();
+}
+
+QImage FrameCache::lookup(const QString& key)
+{
+    if (key.isEmpty()) return QImage();
+    QMutexLocker locker(&mutex);
+    // QCache::object()会把命中的项移到最近使用的位置
+    const QImage* image = images.object(key);
+    return image ? *image : QImage();
+}
+
+void FrameCache::insert(const QString& key, const QImage& image)
+{
+    if (key.isEmpty() || image.isNull()) return;
+    // 图像数据是隐式共享的，缓存中的副本不复制像素
+    const qsizetype costKb = qMax<qsizetype>(1, image.sizeInBytes() / 1024);
+    QMutexLocker locker(&mutex);
+    images.insert(key, new QImage(image), costKb);
+}
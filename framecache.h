@@ -0,0 +1,48 @@
+#ifndef FRAMECACHE_H
+#define FRAMECACHE_H
+
+#include <QCache>
+#include <QImage>
+#include <QMutex>
+#include <QSize>
+#include <QString>
+
+/**
+ * @class FrameCache
+ * @brief 解码后的源图像与缩放后的帧的内存缓存，按最近最少使用淘汰，可在多个线程中使用。
+ *
+ * 渲染服务在任务之间保留该缓存：同一组源图像的多次渲染只在第一次解码和缩放。
+ * 缓存键包含源文件的路径、大小和修改时间，源文件被修改后旧的缓存项不会再被命中。
+ */
+class FrameCache
+{
+public:
+    /// @param capacityMb 缓存容量(MB)，超出时淘汰最久未使用的图像。
+    explicit FrameCache(int capacityMb);
+
+    /**
+     * @brief 生成源文件的缓存键。文件不存在时返回空字符串，不使用缓存。
+     */
+    static QString sourceKey(const QString& path);
+
+    /// @brief 取解码后的源图像，未命中时返回空图像。
+    QImage decodedFrame(const QString& sourceKey);
+
+    /// @brief 取缩放到指定尺寸的帧，未命中时返回空图像。
+    QImage scaledFrame(const QString& sourceKey, const QSize& size);
+
+    void insertDecodedFrame(const QString& sourceKey, const QImage& image);
+    void insertScaledFrame(const QString& sourceKey, const QSize& size, const QImage& image);
+
+    /// @brief 清空缓存。
+    void clear();
+
+private:
+    QMutex mutex;
+    QCache<QString, QImage> images;     ///< 开销以KB计
+
+    QImage lookup(const QString& key);
+    void insert(const QString& key, const QImage& image);
+};
+
+#endif // FRAMECACHE_H
@@ -0,0 +1,136 @@
+#include "frameinterpolation.h"
+
+#include <QPoint>
+#include <cstdlib>
+#include <climits>
+
+namespace {
+
+constexpr int bytesPerPixel = 4; // ARGB32格式
+
+/**
+ * @brief 逐字节线性混合：(a*(256-w) + b*w + 128) / 256。无分支，编译器可以自动向量化。
+ */
+void blendBytes(uchar* __restrict out, const uchar* __restrict a, const uchar* __restrict b, qsizetype count, int weight)
+{
+    const int inverse = 256 - weight;
+    for (qsizetype i = 0; i < count; ++i) {
+        out[i] = static_cast<uchar>((a[i] * inverse + b[i] * weight + 128) >> 8);
+    }
+}
+
+/**
+ * @brief 两个块之间的绝对差之和，超过limit后提前返回。
+ */
+int blockDifference(const uchar* a, const uchar* b, qsizetype bytesPerLine, QPoint aPos, QPoint bPos, int width, int height, int limit)
+{
+    int sum = 0;
+    for (int row = 0; row < height; ++row) {
+        const uchar* aLine = a + (aPos.y() + row) * bytesPerLine + aPos.x() * bytesPerPixel;
+        const uchar* bLine = b + (bPos.y() + row) * bytesPerLine + bPos.x() * bytesPerPixel;
+        for (int i = 0; i < width * bytesPerPixel; ++i) sum += std::abs(aLine[i] - bLine[i]);
+        if (sum >= limit) return sum;
+    }
+    return sum;
+}
+
+/**
+ * @brief 用对称的三步搜索估计一个输出块的运动向量v：前一帧的块在p - v/2，后一帧的块在p + v/2。
+ *
+ * 从零向量开始，步长依次为8、4、2、1，总搜索距离为FrameInterpolator::searchRange。
+ * 在输出块的位置上对称搜索，合成时不会在运动物体之间留下空洞。
+ */
+QPoint estimateMotion(const uchar* first, const uchar* second, int width, int totalRows, QPoint block, int blockWidth, int blockHeight)
+{
+    const qsizetype bytesPerLine = qsizetype(width) * bytesPerPixel;
+    auto difference = [&](QPoint v, int limit) {
+        const QPoint firstHalf(v.x() / 2, v.y() / 2);
+        const QPoint aPos = block - firstHalf;
+        const QPoint bPos = block + (v - firstHalf);
+        if (aPos.x() < 0 || aPos.y() < 0 || bPos.x() < 0 || bPos.y() < 0
+            || aPos.x() + blockWidth > width || bPos.x() + blockWidth > width
+            || aPos.y() + blockHeight > totalRows || bPos.y() + blockHeight > totalRows) {
+            return INT_MAX;
+        }
+        return blockDifference(first, second, bytesPerLine, aPos, bPos, blockWidth, blockHeight, limit);
+    };
+
+    QPoint best(0, 0);
+    int bestDifference = difference(best, INT_MAX);
+    for (int step = 8; step >= 1; step /= 2) {
+        const QPoint center = best;
+        for (int dy = -1; dy <= 1; ++dy) {
+            for (int dx = -1; dx <= 1; ++dx) {
+                if (dx == 0 && dy == 0) continue;
+                const QPoint candidate = center + QPoint(dx, dy) * step;
+                const int candidateDifference = difference(candidate, bestDifference);
+                if (candidateDifference < bestDifference) {
+                    best = candidate;
+                    bestDifference = candidateDifference;
+                }
+            }
+        }
+    }
+    return best;
+}
+
+} // namespace
+
+QList<QByteArray> FrameInterpolator::synthesizeBand(const uchar* first, const uchar* second, int width, int totalRows,
+                                                    int bandOffset, int bandRows, int count, InterpolationMode mode)
+{
+    const qsizetype bytesPerLine = qsizetype(width) * bytesPerPixel;
+    const qsizetype bandBytes = bandRows * bytesPerLine;
+
+    QList<QByteArray> frames;
+    for (int k = 0; k < count; ++k) {
+        QByteArray frame(bandBytes, Qt::Uninitialized);
+        if (frame.size() != bandBytes) return {};
+        frames.append(frame);
+    }
+
+    if (mode == InterpolationMode::CrossFade) {
+        // 条带中的行紧密排列，整个条带一次混合
+        const uchar* a = first + bandOffset * bytesPerLine;
+        const uchar* b = second + bandOffset * bytesPerLine;
+        for (int k = 0; k < count; ++k) {
+            const int weight = (k + 1) * 256 / (count + 1);
+            blendBytes(reinterpret_cast<uchar*>(frames[k].data()), a, b, bandBytes, weight);
+        }
+        return frames;
+    }
+
+    // 块匹配：每个块估计一次运动，各中间帧共用；块内的每一行是一次连续混合
+    QList<uchar*> outputs;
+    for (QByteArray& frame : frames) outputs.append(reinterpret_cast<uchar*>(frame.data()));
+
+    for (int blockY = 0; blockY < bandRows; blockY += blockSize) {
+        const int blockHeight = qMin(blockSize, bandRows - blockY);
+        for (int blockX = 0; blockX < width; blockX += blockSize) {
+            const int blockWidth = qMin(blockSize, width - blockX);
+            const QPoint motion = estimateMotion(first, second, width, totalRows,
+                                                 QPoint(blockX, bandOffset + blockY), blockWidth, blockHeight);
+
+            for (int k = 0; k < count; ++k) {
+                // t时刻位于q的内容，来自前一帧的q - t*v和后一帧的q + (1-t)*v
+                const double t = double(k + 1) / (count + 1);
+                const int weight = (k + 1) * 256 / (count + 1);
+                const QPoint toFirst(qRound(t * motion.x()), qRound(t * motion.y()));
+                const QPoint toSecond = motion - toFirst;
+                const int aX = qBound(0, blockX - toFirst.x(), width - blockWidth);
+                const int bX = qBound(0, blockX + toSecond.x(), width - blockWidth);
+
+                for (int row = 0; row < blockHeight; ++row) {
+                    const int y = bandOffset + blockY + row;
+                    const int aY = qBound(0, y - toFirst.y(), totalRows - 1);
+                    const int bY = qBound(0, y + toSecond.y(), totalRows - 1);
+                    blendBytes(outputs[k] + (blockY + row) * bytesPerLine + blockX * bytesPerPixel,
+                               first + aY * bytesPerLine + aX * bytesPerPixel,
+                               second + bY * bytesPerLine + bX * bytesPerPixel,
+                               blockWidth * bytesPerPixel, weight);
+                }
+            }
+        }
+    }
+    return frames;
+}
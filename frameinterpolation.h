@@ -0,0 +1,51 @@
+#ifndef FRAMEINTERPOLATION_H
+#define FRAMEINTERPOLATION_H
+
+#include <QByteArray>
+#include <QList>
+#include <QtGlobal>
+
+/// @brief 中间帧的合成方式。
+enum class InterpolationMode {
+    CrossFade,      ///< 交叉淡化：按时间位置混合前后两帧
+    BlockMatching   ///< 块匹配运动估计：按估计出的运动把前后两帧移到中间位置再混合
+};
+
+/**
+ * @class FrameInterpolator
+ * @brief 在两张相邻帧之间合成中间帧，按条带进行，合成结果直接交给合成器，不写出文件。
+ *
+ * 输入是两帧在同一范围内的行(紧密排列的ARGB32)，可以比条带多出上下若干行，
+ * 块匹配时运动向量可以指向条带之外的这些行。各条带在线程池中并行合成。
+ */
+class FrameInterpolator
+{
+public:
+    /// @brief 块匹配的块大小(像素)。
+    static constexpr int blockSize = 16;
+
+    /// @brief 块匹配的最大搜索距离(像素)，条带上下需要至少这么多额外的行。
+    static constexpr int searchRange = 15;
+
+    /**
+     * @brief 合成一个条带的中间帧。
+     * @param first 前一帧的行数据，共totalRows行。
+     * @param second 后一帧的行数据，与first范围相同。
+     * @param width 每行的像素数。
+     * @param totalRows first和second中的行数。
+     * @param bandOffset 条带第一行在first中的行号。
+     * @param bandRows 条带的行数。
+     * @param count 要合成的中间帧数，第k帧位于前后两帧之间(k+1)/(count+1)处。
+     * @return count个数据块，各含bandRows行紧密排列的ARGB32像素；内存不足时返回空列表。
+     */
+    static QList<QByteArray> synthesizeBand(const uchar* first, const uchar* second, int width, int totalRows,
+                                            int bandOffset, int bandRows, int count, InterpolationMode mode);
+
+    /// @brief 导入帧数为importedCount、每两帧之间插入inBetween帧时的总帧数。
+    static int totalFrameCount(int importedCount, int inBetween)
+    {
+        return importedCount + qMax(0, importedCount - 1) * qMax(0, inBetween);
+    }
+};
+
+#endif // FRAMEINTERPOLATION_H
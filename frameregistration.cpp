@@ -0,0 +1,207 @@
+#include "frameregistration.h"
+
+#include <QImage>
+#include <QImageReader>
+#include <QtConcurrent/QtConcurrentMap>
+#include <complex>
+#include <vector>
+#include <optional>
+#include <cmath>
+#include <stdexcept>
+
+namespace {
+
+using Complex = std::complex<double>;
+
+/// @brief 只在此范围内寻找相关峰(分析尺寸的比例)，更大的平移视为不可靠
+constexpr double maxShiftFraction = 0.25;
+
+/**
+ * @brief 原地一维基2 FFT。inverse为true时做逆变换，不做归一化。
+ */
+void fft(std::vector<Complex>& data, bool inverse)
+{
+    const int n = static_cast<int>(data.size());
+    for (int i = 1, j = 0; i < n; ++i) {
+        int bit = n >> 1;
+        for (; j & bit; bit >>= 1) j ^= bit;
+        j ^= bit;
+        if (i < j) std::swap(data[i], data[j]);
+    }
+    for (int length = 2; length <= n; length <<= 1) {
+        const double angle = 2.0 * M_PI / length * (inverse ? 1.0 : -1.0);
+        const Complex step(std::cos(angle), std::sin(angle));
+        for (int start = 0; start < n; start += length) {
+            Complex w(1.0);
+            for (int k = 0; k < length / 2; ++k) {
+                const Complex u = data[start + k];
+                const Complex v = data[start + k + length / 2] * w;
+                data[start + k] = u + v;
+                data[start + k + length / 2] = u - v;
+                w *= step;
+            }
+        }
+    }
+}
+
+/**
+ * @brief 对n×n的数据按行、再按列做二维FFT。
+ */
+void fft2d(std::vector<Complex>& data, int n, bool inverse)
+{
+    std::vector<Complex> line(n);
+    for (int y = 0; y < n; ++y) {
+        std::copy(data.begin() + y * n, data.begin() + (y + 1) * n, line.begin());
+        fft(line, inverse);
+        std::copy(line.begin(), line.end(), data.begin() + y * n);
+    }
+    for (int x = 0; x < n; ++x) {
+        for (int y = 0; y < n; ++y) line[y] = data[y * n + x];
+        fft(line, inverse);
+        for (int y = 0; y < n; ++y) data[y * n + x] = line[y];
+    }
+}
+
+/**
+ * @brief 以缩小的灰度图计算一帧加窗后的频谱。无法加载时返回空数组。
+ *
+ * 缩小直接在解码时进行(JPEG等格式可跳过大部分解码工作)，并且不保持宽高比，偏移按宽高比例换算回原图。
+ * 按EXIF方向摆正后再分析，偏移的坐标轴与阶段一摆正后的画面一致；分析尺寸是正方形，摆正与缩小的先后不影响结果。
+ */
+std::vector<Complex> windowedSpectrum(const QString& path, bool exifOrientation)
+{
+    const int n = FrameAligner::analysisSize;
+    QImageReader reader(path);
+    reader.setAutoTransform(exifOrientation);
+    reader.setScaledSize(QSize(n, n));
+    QImage image = reader.read();
+    if (image.isNull()) return {};
+    image = image.convertToFormat(QImage::Format_Grayscale8);
+    if (image.size() != QSize(n, n)) image = image.scaled(n, n, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+
+    double mean = 0.0;
+    for (int y = 0; y < n; ++y) {
+        const uchar* line = image.constScanLine(y);
+        for (int x = 0; x < n; ++x) mean += line[x];
+    }
+    mean /= double(n) * n;
+
+    // 去均值并加汉宁窗，抑制图像边缘的不连续在频谱中产生的十字形干扰
+    std::vector<double> window(n);
+    for (int i = 0; i < n; ++i) window[i] = 0.5 - 0.5 * std::cos(2.0 * M_PI * i / (n - 1));
+
+    std::vector<Complex> spectrum(size_t(n) * n);
+    for (int y = 0; y < n; ++y) {
+        const uchar* line = image.constScanLine(y);
+        for (int x = 0; x < n; ++x) {
+            spectrum[size_t(y) * n + x] = (line[x] - mean) * window[x] * window[y];
+        }
+    }
+    fft2d(spectrum, n, false);
+    return spectrum;
+}
+
+/**
+ * @brief 三点抛物线拟合的峰值位置，相对中间点，范围[-0.5, 0.5]。
+ */
+double parabolicPeak(double left, double center, double right)
+{
+    const double denominator = left - 2.0 * center + right;
+    if (std::abs(denominator) < 1e-12) return 0.0;
+    return qBound(-0.5, 0.5 * (left - right) / denominator, 0.5);
+}
+
+/**
+ * @brief 相位相关：由两帧的频谱求frame相对reference的平移(分析尺寸的比例)。
+ */
+QPointF phaseCorrelate(const std::vector<Complex>& reference, std::vector<Complex> frame)
+{
+    const int n = FrameAligner::analysisSize;
+
+    // 归一化互功率谱，只保留相位
+    for (size_t k = 0; k < frame.size(); ++k) {
+        const Complex cross = frame[k] * std::conj(reference[k]);
+        const double magnitude = std::abs(cross);
+        frame[k] = magnitude > 1e-12 ? cross / magnitude : Complex(0.0);
+    }
+    fft2d(frame, n, true);
+
+    auto valueAt = [&frame, n](int x, int y) {
+        return frame[size_t((y + n) % n) * n + (x + n) % n].real();
+    };
+
+    const int maxShift = static_cast<int>(n * maxShiftFraction);
+    int peakX = 0;
+    int peakY = 0;
+    for (int y = -maxShift; y <= maxShift; ++y) {
+        for (int x = -maxShift; x <= maxShift; ++x) {
+            if (valueAt(x, y) > valueAt(peakX, peakY)) {
+                peakX = x;
+                peakY = y;
+            }
+        }
+    }
+
+    const double center = valueAt(peakX, peakY);
+    const double dx = peakX + parabolicPeak(valueAt(peakX - 1, peakY), center, valueAt(peakX + 1, peakY));
+    const double dy = peakY + parabolicPeak(valueAt(peakX, peakY - 1), center, valueAt(peakX, peakY + 1));
+    return QPointF(dx / n, dy / n);
+}
+
+} // namespace
+
+QList<QPointF> FrameAligner::estimateOffsets(const QList<QString>& imagePaths, const QList<bool>& exifOrientations)
+{
+    QList<QPointF> offsets(imagePaths.size());
+    if (imagePaths.size() < 2) return offsets;
+
+    const std::vector<Complex> reference = windowedSpectrum(imagePaths.first(), exifOrientations.value(0, true));
+    if (reference.empty()) throw std::runtime_error("无法加载源文件。");
+
+    // 各帧与第一帧的相关互不依赖，并行计算
+    QList<int> frameIndices;
+    for (int i = 1; i < imagePaths.size(); ++i) frameIndices.append(i);
+    const QList<std::optional<QPointF>> shifts = QtConcurrent::blockingMapped(frameIndices, [&](int i) {
+        std::vector<Complex> spectrum = windowedSpectrum(imagePaths[i], exifOrientations.value(i, true));
+        if (spectrum.empty()) return std::optional<QPointF>();
+        return std::optional<QPointF>(phaseCorrelate(reference, std::move(spectrum)));
+    });
+
+    for (int i = 1; i < imagePaths.size(); ++i) {
+        if (!shifts[i - 1]) throw std::runtime_error("无法加载源文件。");
+        offsets[i] = *shifts[i - 1];
+    }
+    return offsets;
+}
+
+QRectF FrameAligner::alignedSourceRect(const QSize& sourceSize, const QList<QPointF>& offsets, int frameIndex,
+                                       const QSize& targetSize)
+{
+    // 参考画面中的点u出现在第i帧的u + d[i]处，所有帧都包含的参考区域为[-min(d), 1 - max(d)]
+    double minX = 0.0, maxX = 0.0, minY = 0.0, maxY = 0.0;
+    for (const QPointF& offset : offsets) {
+        minX = qMin(minX, offset.x());
+        maxX = qMax(maxX, offset.x());
+        minY = qMin(minY, offset.y());
+        maxY = qMax(maxY, offset.y());
+    }
+    const double width = 1.0 - (maxX - minX);
+    const double height = 1.0 - (maxY - minY);
+    const QPointF offset = offsets.value(frameIndex);
+    if (width <= 0.0 || height <= 0.0) return QRectF(QPointF(0, 0), QSizeF(sourceSize));
+
+    QRectF rect((offset.x() - minX) * sourceSize.width(), (offset.y() - minY) * sourceSize.height(),
+                width * sourceSize.width(), height * sourceSize.height());
+    if (targetSize.isEmpty()) return rect;
+
+    // 多出的一边从两侧等量裁掉，各帧裁切量相同，内容仍然对齐
+    const double targetAspect = double(targetSize.width()) / targetSize.height();
+    if (rect.width() / rect.height() > targetAspect) {
+        const double croppedWidth = rect.height() * targetAspect;
+        rect.adjust((rect.width() - croppedWidth) / 2.0, 0.0, -(rect.width() - croppedWidth) / 2.0, 0.0);
+    } else {
+        const double croppedHeight = rect.width() / targetAspect;
+        rect.adjust(0.0, (rect.height() - croppedHeight) / 2.0, 0.0, -(rect.height() - croppedHeight) / 2.0);
+    }
+    return rect;
+}
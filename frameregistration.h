@@ -0,0 +1,44 @@
+#ifndef FRAMEREGISTRATION_H
+#define FRAMEREGISTRATION_H
+
+#include <QList>
+#include <QPointF>
+#include <QRectF>
+#include <QSize>
+#include <QString>
+
+/**
+ * @class FrameAligner
+ * @brief 手持拍摄的帧序列的自动对齐：估计每帧相对第一帧的平移，并给出各帧对齐后应取的源图像区域。
+ *
+ * 平移用相位相关法在缩小的灰度图上估计，峰值处做抛物线拟合得到亚像素精度。
+ * 偏移以帧宽高的比例表示，与帧的实际分辨率无关。对齐在阶段一的缩放中完成，不额外处理全分辨率图像。
+ * 偏移在按EXIF方向摆正后的画面上估计，与阶段一取对齐区域时使用的坐标一致；裁切、平移和旋转相对于对齐区域进行。
+ */
+class FrameAligner
+{
+public:
+    /// @brief 相位相关使用的分析尺寸(2的幂)。
+    static constexpr int analysisSize = 512;
+
+    /**
+     * @brief 估计各帧相对第一帧的平移。各帧在线程池中并行计算。
+     * @param exifOrientations 每帧是否按EXIF方向摆正(见FrameTransform::exifOrientation)，缺省的帧摆正。
+     * @return 每帧一个偏移(摆正后帧宽高的比例)，第一帧为(0,0)。帧内容相对第一帧向右下移动时为正。
+     * 出错时抛出std::exception。
+     */
+    static QList<QPointF> estimateOffsets(const QList<QString>& imagePaths, const QList<bool>& exifOrientations = {});
+
+    /**
+     * @brief 计算对齐后帧frameIndex应取的源图像区域。
+     *
+     * 所有帧都只取各帧共有的画面部分，区域按该帧的偏移平移，因此各帧的区域大小相同、内容对齐。
+     * @param sourceSize 该帧(或其缩小图)的像素尺寸。
+     * @param targetSize 区域要缩放到的尺寸。有效时共有区域再居中裁切为目标的宽高比，
+     * 只在一个方向上有偏移时画面不会被拉伸，与有画面调整的帧(FrameTransformer)一致。
+     */
+    static QRectF alignedSourceRect(const QSize& sourceSize, const QList<QPointF>& offsets, int frameIndex,
+                                    const QSize& targetSize = QSize());
+};
+
+#endif // FRAMEREGISTRATION_H
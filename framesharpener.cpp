@@ -0,0 +1,133 @@
+#include "framesharpener.h"
+#include "scratchframe.h"
+
+#include <QList>
+#include <QtConcurrent/QtConcurrentMap>
+#include <vector>
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+constexpr int bytesPerPixel = 4; // ARGB32格式
+
+/// @brief 一维卷积核的权重精度：权重之和为256，两次卷积后放大2^16倍
+constexpr int weightScale = 256;
+
+/**
+ * @brief 生成一维高斯核，权重为整数且总和恰好为weightScale。
+ */
+std::vector<int> gaussianKernel(double sigma)
+{
+    const int halfWidth = qMax(1, static_cast<int>(std::ceil(sigma * 3.0)));
+    std::vector<double> weights(2 * halfWidth + 1);
+    double sum = 0.0;
+    for (int k = -halfWidth; k <= halfWidth; ++k) {
+        weights[k + halfWidth] = std::exp(-0.5 * k * k / (sigma * sigma));
+        sum += weights[k + halfWidth];
+    }
+
+    std::vector<int> kernel(weights.size());
+    int total = 0;
+    for (size_t i = 0; i < weights.size(); ++i) {
+        kernel[i] = static_cast<int>(std::lround(weights[i] / sum * weightScale));
+        total += kernel[i];
+    }
+    // 舍入误差补到中心，保证平坦区域的模糊结果不变
+    kernel[halfWidth] += weightScale - total;
+    return kernel;
+}
+
+/**
+ * @brief 水平卷积一行：先把行两端按边缘像素延长，再对每个字节做乘加，结果为放大weightScale倍的值。
+ */
+void blurRowHorizontally(const uchar* line, int width, const std::vector<int>& kernel,
+                         std::vector<uchar>& padded, std::vector<int>& accumulator, quint16* out)
+{
+    const int halfWidth = static_cast<int>(kernel.size() / 2);
+    const qsizetype lineBytes = qsizetype(width) * bytesPerPixel;
+
+    for (int k = 0; k < halfWidth; ++k) {
+        memcpy(padded.data() + k * bytesPerPixel, line, bytesPerPixel);
+        memcpy(padded.data() + (halfWidth + width + k) * bytesPerPixel, line + lineBytes - bytesPerPixel, bytesPerPixel);
+    }
+    memcpy(padded.data() + halfWidth * bytesPerPixel, line, lineBytes);
+
+    std::fill(accumulator.begin(), accumulator.begin() + lineBytes, 0);
+    int* __restrict sum = accumulator.data();
+    for (size_t k = 0; k < kernel.size(); ++k) {
+        const int weight = kernel[k];
+        const uchar* __restrict source = padded.data() + k * bytesPerPixel;
+        for (qsizetype i = 0; i < lineBytes; ++i) sum[i] += weight * source[i];
+    }
+    for (qsizetype i = 0; i < lineBytes; ++i) out[i] = static_cast<quint16>(sum[i]);
+}
+
+/**
+ * @brief 锐化一个行块：水平卷积块内及上下halfWidth行，再垂直卷积并与原图混合。
+ */
+void sharpenRows(const QImage& source, uchar* resultBits, qsizetype resultBytesPerLine, int firstRow, int rowCount,
+                 const std::vector<int>& kernel, int amountFixed)
+{
+    const int width = source.width();
+    const int height = source.height();
+    const int halfWidth = static_cast<int>(kernel.size() / 2);
+    const qsizetype lineBytes = qsizetype(width) * bytesPerPixel;
+
+    // 水平卷积的结果，包含块上下各halfWidth行(超出图像的行取边缘行)
+    const int bufferRows = rowCount + 2 * halfWidth;
+    std::vector<quint16> horizontal(size_t(bufferRows) * lineBytes);
+    std::vector<uchar> padded(size_t(width + 2 * halfWidth) * bytesPerPixel);
+    std::vector<int> accumulator(lineBytes);
+    for (int r = 0; r < bufferRows; ++r) {
+        const int y = qBound(0, firstRow - halfWidth + r, height - 1);
+        blurRowHorizontally(source.constScanLine(y), width, kernel, padded, accumulator,
+                            horizontal.data() + size_t(r) * lineBytes);
+    }
+
+    for (int r = 0; r < rowCount; ++r) {
+        int* __restrict sum = accumulator.data();
+        std::fill(accumulator.begin(), accumulator.end(), 0);
+        for (size_t k = 0; k < kernel.size(); ++k) {
+            const int weight = kernel[k];
+            const quint16* __restrict row = horizontal.data() + size_t(r + k) * lineBytes;
+            for (qsizetype i = 0; i < lineBytes; ++i) sum[i] += weight * row[i];
+        }
+
+        // 输出 = 原图 + amount * (原图 - 模糊)，模糊值放大了weightScale²倍
+        const uchar* __restrict original = source.constScanLine(firstRow + r);
+        uchar* __restrict out = resultBits + (firstRow + r) * resultBytesPerLine;
+        for (qsizetype i = 0; i < lineBytes; ++i) {
+            const int blurred = (sum[i] + weightScale * weightScale / 2) >> 16;
+            const int value = original[i] + (((original[i] - blurred) * amountFixed + 128) >> 8);
+            out[i] = static_cast<uchar>(qBound(0, value, 255));
+        }
+    }
+}
+
+} // namespace
+
+QImage FrameSharpener::apply(const QImage& image, double amount, double radius)
+{
+    if (amount <= 0.0 || radius <= 0.0 || image.isNull()) return image;
+
+    const QImage source = image.format() == QImage::Format_ARGB32 ? image : image.convertToFormat(QImage::Format_ARGB32);
+    QImage result(source.size(), QImage::Format_ARGB32);
+    if (source.isNull() || result.isNull()) return QImage();
+
+    const std::vector<int> kernel = gaussianKernel(qMin(radius, maxRadius));
+    const int amountFixed = qRound(amount * 256.0);
+
+    // 先取出写指针：并行任务中调用非const的scanLine()会并发修改图像的内部状态
+    uchar* resultBits = result.bits();
+    const qsizetype resultBytesPerLine = result.bytesPerLine();
+
+    // 与临时文件的块同样按64行分块，各块互不依赖
+    const int blockRows = ScratchFrameFile::blockRows;
+    QList<int> firstRows;
+    for (int y = 0; y < source.height(); y += blockRows) firstRows.append(y);
+    QtConcurrent::blockingMap(firstRows, [&](int firstRow) {
+        sharpenRows(source, resultBits, resultBytesPerLine, firstRow, qMin(blockRows, source.height() - firstRow), kernel, amountFixed);
+    });
+    return result;
+}
@@ -0,0 +1,28 @@
+#ifndef FRAMESHARPENER_H
+#define FRAMESHARPENER_H
+
+#include <QImage>
+
+/**
+ * @class FrameSharpener
+ * @brief 缩放后的帧的USM锐化，补偿缩小和光栅板造成的清晰度损失。
+ *
+ * 高斯模糊拆分为水平和垂直两个一维卷积，按行块在线程池中并行计算，每块只需上下少量额外的行。
+ * 卷积和混合都用定点整数在连续的字节上计算，没有分支，编译器可以自动向量化。
+ */
+class FrameSharpener
+{
+public:
+    /**
+     * @brief 对ARGB32图像做USM锐化：输出 = 原图 + amount * (原图 - 高斯模糊)。
+     * @param amount 锐化强度，0为不锐化，1为100%。
+     * @param radius 高斯模糊的标准差(像素)。
+     * @return 锐化后的图像；内存不足时返回空图像。
+     */
+    static QImage apply(const QImage& image, double amount, double radius);
+
+    /// @brief 锐化半径的上限(像素)。
+    static constexpr double maxRadius = 5.0;
+};
+
+#endif // FRAMESHARPENER_H
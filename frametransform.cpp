@@ -0,0 +1,166 @@
+#include "frametransform.h"
+#include "linearscaler.h"
+
+#include <QImageReader>
+#include <QImageIOHandler>
+#include <QJsonArray>
+#include <QPainter>
+#include <cmath>
+#include <stdexcept>
+
+namespace {
+
+/// @brief 解码区域在取景区域之外多留的像素，供双线性重采样读取边缘的相邻像素
+constexpr int clipMargin = 2;
+
+/// @brief 缩小超过这个倍数时，先用平滑缩放把源区域缩到接近目标分辨率，避免双线性重采样产生锯齿
+constexpr double maxDirectDownscale = 2.0;
+
+/**
+ * @brief 文件中的像素坐标到摆正后坐标的变换，与QImageReader自动摆正的顺序一致：先镜像、翻转，再顺时针旋转90度。
+ */
+QTransform orientationTransform(const QSize& rawSize, QImageIOHandler::Transformations orientation)
+{
+    QTransform matrix;
+    if (orientation & QImageIOHandler::TransformationMirror) matrix *= QTransform(-1, 0, 0, 1, rawSize.width(), 0);
+    if (orientation & QImageIOHandler::TransformationFlip) matrix *= QTransform(1, 0, 0, -1, 0, rawSize.height());
+    if (orientation & QImageIOHandler::TransformationRotate90) matrix *= QTransform(0, 1, -1, 0, rawSize.height(), 0);
+    return matrix;
+}
+
+} // namespace
+
+bool FrameTransform::isIdentity() const
+{
+    return crop == QRectF(0.0, 0.0, 1.0, 1.0) && pan.isNull() && rotation == 0.0 && exifOrientation;
+}
+
+QSize FrameTransform::framedSize(const QSize& orientedSize) const
+{
+    if (orientedSize.isEmpty()) return QSize();
+    return QSize(qMax(1, qRound(crop.width() * orientedSize.width())),
+                 qMax(1, qRound(crop.height() * orientedSize.height())));
+}
+
+QString FrameTransform::cacheKey() const
+{
+    return QString("crop %1,%2,%3,%4 pan %5,%6 rotate %7 exif %8")
+        .arg(crop.x()).arg(crop.y()).arg(crop.width()).arg(crop.height())
+        .arg(pan.x()).arg(pan.y()).arg(rotation).arg(exifOrientation ? 1 : 0);
+}
+
+QJsonObject FrameTransform::toJson() const
+{
+    QJsonObject json;
+    json["crop"] = QJsonArray{crop.x(), crop.y(), crop.width(), crop.height()};
+    json["pan"] = QJsonArray{pan.x(), pan.y()};
+    json["rotation"] = rotation;
+    json["exifOrientation"] = exifOrientation;
+    return json;
+}
+
+FrameTransform FrameTransform::fromJson(const QJsonObject& json)
+{
+    FrameTransform transform;
+    const QJsonArray crop = json["crop"].toArray();
+    if (crop.size() == 4 && crop[2].toDouble() > 0.0 && crop[3].toDouble() > 0.0) {
+        transform.crop = QRectF(crop[0].toDouble(), crop[1].toDouble(), crop[2].toDouble(), crop[3].toDouble());
+    }
+    const QJsonArray pan = json["pan"].toArray();
+    if (pan.size() == 2) transform.pan = QPointF(pan[0].toDouble(), pan[1].toDouble());
+    transform.rotation = json["rotation"].toDouble(transform.rotation);
+    transform.exifOrientation = json["exifOrientation"].toBool(transform.exifOrientation);
+    return transform;
+}
+
+QSize FrameTransformer::orientedSize(const QString& path, bool exifOrientation)
+{
+    QImageReader reader(path);
+    const QSize rawSize = reader.size();
+    if (!rawSize.isValid()) return QSize();
+    const bool rotated = exifOrientation && (reader.transformation() & QImageIOHandler::TransformationRotate90);
+    return rotated ? rawSize.transposed() : rawSize;
+}
+
+QTransform FrameTransformer::viewTransform(const FrameTransform& transform, const QRectF& frameRect, const QSize& targetSize)
+{
+    const QSizeF viewSize(transform.crop.width() * frameRect.width(), transform.crop.height() * frameRect.height());
+    const QPointF center(frameRect.x() + (transform.crop.center().x() + transform.pan.x()) * frameRect.width(),
+                         frameRect.y() + (transform.crop.center().y() + transform.pan.y()) * frameRect.height());
+    const double scale = qMax(targetSize.width() / viewSize.width(), targetSize.height() / viewSize.height());
+
+    // 点依次经过：移到取景中心、旋转、缩放、移到目标中心
+    QTransform view;
+    view.translate(targetSize.width() / 2.0, targetSize.height() / 2.0);
+    view.scale(scale, scale);
+    view.rotate(transform.rotation);
+    view.translate(-center.x(), -center.y());
+    return view;
+}
+
+QList<QImage> FrameTransformer::render(const QString& path, const FrameTransform& transform,
+                                       const QRectF& alignedRect, const QList<QSize>& targetSizes, bool linearLight)
+{
+    // 自动摆正关闭，裁切区域才是文件中的像素坐标；摆正与其余调整一起在重采样中完成
+    QImageReader reader(path);
+    reader.setAutoTransform(false);
+    const QSize rawSize = reader.size();
+    if (!rawSize.isValid()) throw std::runtime_error("无法加载源文件。");
+
+    const QImageIOHandler::Transformations orientation = transform.exifOrientation
+        ? reader.transformation() : QImageIOHandler::Transformations(QImageIOHandler::TransformationNone);
+    const QTransform toOriented = orientationTransform(rawSize, orientation);
+    const QSize oriented = (orientation & QImageIOHandler::TransformationRotate90) ? rawSize.transposed() : rawSize;
+    const QRectF frameRect(alignedRect.x() * oriented.width(), alignedRect.y() * oriented.height(),
+                           alignedRect.width() * oriented.width(), alignedRect.height() * oriented.height());
+
+    // 各目标的取景区域映射回文件中的像素，合并后作为解码的裁切区域
+    QList<QTransform> fromRaw;
+    QRectF neededRect;
+    for (const QSize& targetSize : targetSizes) {
+        fromRaw.append(toOriented * viewTransform(transform, frameRect, targetSize));
+        neededRect |= fromRaw.last().inverted().mapRect(QRectF(QPointF(0, 0), QSizeF(targetSize)));
+    }
+    const QRect clipRect = neededRect.toAlignedRect().adjusted(-clipMargin, -clipMargin, clipMargin, clipMargin)
+                           & QRect(QPoint(0, 0), rawSize);
+
+    QImage region;
+    if (!clipRect.isEmpty()) {
+        reader.setClipRect(clipRect);
+        region = reader.read();
+        if (region.isNull()) throw std::runtime_error("无法加载源文件。");
+        region = region.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+    }
+
+    QList<QImage> results;
+    for (qsizetype i = 0; i < targetSizes.size(); ++i) {
+        QImage result(targetSizes[i], QImage::Format_ARGB32);
+        if (result.isNull()) throw std::runtime_error("在缩放图像时内存不足。");
+        result.fill(Qt::white);
+        if (region.isNull()) {
+            results.append(result);
+            continue;
+        }
+
+        // 裁切区域左上角是文件中的clipRect.topLeft()
+        QTransform sourceToTarget = QTransform::fromTranslate(clipRect.x(), clipRect.y()) * fromRaw[i];
+        QImage source = region;
+        const double sourcePerTarget = 1.0 / std::sqrt(std::abs(sourceToTarget.determinant()));
+        if (sourcePerTarget > maxDirectDownscale) {
+            const QSize prescaledSize(qMax(1, qRound(region.width() / sourcePerTarget)), qMax(1, qRound(region.height() / sourcePerTarget)));
+            source = linearLight ? LinearLightScaler::scale(region, prescaledSize)
+                                 : region.scaled(prescaledSize, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+            if (source.isNull()) throw std::runtime_error("在缩放图像时内存不足。");
+            sourceToTarget = QTransform::fromScale(double(region.width()) / source.width(), double(region.height()) / source.height())
+                             * sourceToTarget;
+        }
+
+        QPainter painter(&result);
+        painter.setRenderHint(QPainter::SmoothPixmapTransform);
+        painter.setTransform(sourceToTarget);
+        painter.drawImage(QPointF(0, 0), source);
+        painter.end();
+        results.append(result);
+    }
+    return results;
+}
@@ -0,0 +1,68 @@
+#ifndef FRAMETRANSFORM_H
+#define FRAMETRANSFORM_H
+
+#include <QImage>
+#include <QJsonObject>
+#include <QList>
+#include <QPointF>
+#include <QRectF>
+#include <QSize>
+#include <QString>
+#include <QTransform>
+
+/**
+ * @struct FrameTransform
+ * @brief 单帧的非破坏性画面调整：按EXIF方向摆正、裁切、平移和旋转。
+ *
+ * 调整只作为参数保存，不生成中间文件。裁切和平移以摆正后源图像宽高的比例表示，与源图像的分辨率无关。
+ */
+struct FrameTransform {
+    QRectF crop = QRectF(0.0, 0.0, 1.0, 1.0);  ///< 取景区域
+    QPointF pan;                               ///< 取景区域的平移
+    double rotation = 0.0;                     ///< 画面绕取景区域中心顺时针旋转的角度(度)
+    bool exifOrientation = true;               ///< 是否按EXIF方向信息摆正源图像
+
+    /// @brief 是否没有任何调整。没有调整的帧沿用整幅解码、直接缩放的流程。
+    bool isIdentity() const;
+
+    /// @brief 取景区域在摆正后源图像上的像素尺寸。第一帧的这一尺寸决定输出图像的宽高比。
+    QSize framedSize(const QSize& orientedSize) const;
+
+    /// @brief 区分不同调整的字符串，计入帧缓存的键和重复帧的判断。
+    QString cacheKey() const;
+
+    QJsonObject toJson() const;
+    static FrameTransform fromJson(const QJsonObject& json);
+};
+
+/**
+ * @class FrameTransformer
+ * @brief 按FrameTransform读取一帧并重采样到目标尺寸。
+ *
+ * 只解码取景区域覆盖的源像素(QImageReader的裁切区域)，摆正、裁切、平移、旋转和缩放合并为一次重采样。
+ * 阶段一和预览使用同一套计算，预览与最终输出的取景一致。
+ */
+class FrameTransformer
+{
+public:
+    /// @brief 读取源图像摆正后的尺寸，不解码像素。无法读取时返回空尺寸。
+    static QSize orientedSize(const QString& path, bool exifOrientation);
+
+    /**
+     * @brief 计算把摆正后源图像坐标映射到目标图像坐标的变换。
+     * @param frameRect 作为整帧的区域(摆正后源图像坐标)，对齐时为对齐后各帧共有的区域。
+     * 取景区域按等比例铺满目标，多出的部分居中裁掉，画面不会变形。
+     */
+    static QTransform viewTransform(const FrameTransform& transform, const QRectF& frameRect, const QSize& targetSize);
+
+    /**
+     * @brief 读取一帧并渲染到各目标尺寸。取景区域超出源图像的部分填充白色。
+     * @param alignedRect 对齐后应取的区域，以摆正后源图像宽高的比例表示；不对齐时为(0,0,1,1)。
+     * @param linearLight 大比例缩小时的预缩放是否在线性光空间中进行。
+     * @return 与targetSizes一一对应的ARGB32图像。出错时抛出std::exception。
+     */
+    static QList<QImage> render(const QString& path, const FrameTransform& transform,
+                                const QRectF& alignedRect, const QList<QSize>& targetSizes, bool linearLight = false);
+};
+
+#endif // FRAMETRANSFORM_H
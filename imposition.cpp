@@ -0,0 +1,249 @@
+#include "imposition.h"
+#include "tiffwriter.h"
+#include "renderjournal.h"
+
+#include <QColorSpace>
+#include <QFile>
+#include <QImageReader>
+#include <QThreadPool>
+#include <QQueue>
+#include <QFuture>
+#include <QScopeGuard>
+#include <QtConcurrent/QtConcurrentRun>
+#include <QtConcurrent/QtConcurrentMap>
+#include <stdexcept>
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+/// @brief 卡片分辨率与纸张分辨率允许的偏差(DPI)，容纳文件中以每米点数保存时的取整误差
+constexpr double maxDpiDeviation = 0.5;
+
+} // namespace
+
+SheetImposer::SheetImposer(const ImpositionSettings& settings)
+    : settings(settings)
+{}
+
+int SheetImposer::cmToPixels(double cm) const
+{
+    return static_cast<int>(std::round(cm / 2.54 * settings.dpi));
+}
+
+QSize SheetImposer::sheetPixelSize() const
+{
+    return QSize(cmToPixels(settings.sheetWidthCm), cmToPixels(settings.sheetHeightCm));
+}
+
+QList<ImpositionPlacement> SheetImposer::layout(const QList<QSize>& cardSizes) const
+{
+    QList<ImpositionPlacement> placements;
+    if (cardSizes.isEmpty() || settings.dpi <= 0.0 || settings.lpi <= 0.0) return placements;
+
+    const QSize sheetSize = sheetPixelSize();
+    const int margin = cmToPixels(settings.marginCm);
+    const int gutter = cmToPixels(settings.gutterCm);
+    const int right = sheetSize.width() - margin;
+    const int bottom = sheetSize.height() - margin;
+
+    // 光栅单元在纸张上的像素间距，以留白内侧为对齐原点
+    const double lenticulePitch = settings.dpi / settings.lpi;
+    auto snapToLenticule = [&](int position) {
+        return margin + static_cast<int>(std::ceil((position - margin) / lenticulePitch - 1e-6) * lenticulePitch + 0.5);
+    };
+
+    // 待排列的卡片序列：指定份数时按顺序重复，否则循环排列直到排满
+    const bool fillSheet = settings.copiesPerCard <= 0;
+    const int instanceCount = fillSheet ? maxFillPlacements : cardSizes.size() * settings.copiesPerCard;
+
+    // 按行依次排列；纵向光栅对齐每张卡片的X，横向光栅对齐每一行的Y，二维交错的透镜两个方向间距相同，都要对齐
+    const bool snapX = settings.isGrid || settings.isVertical;
+    const bool snapY = settings.isGrid || !settings.isVertical;
+    int x = margin;
+    int rowTop = snapY ? snapToLenticule(margin) : margin;
+    int rowHeight = 0;
+    for (int i = 0; i < instanceCount; ++i) {
+        const int cardIndex = fillSheet ? i % cardSizes.size() : i / settings.copiesPerCard;
+        const QSize size = cardSizes[cardIndex];
+        if (size.isEmpty()) return {};
+
+        int cardX = snapX ? snapToLenticule(x) : x;
+        if (cardX + size.width() > right && rowHeight > 0) {
+            // 换行
+            x = margin;
+            cardX = snapX ? snapToLenticule(x) : x;
+            rowTop += rowHeight + gutter;
+            if (snapY) rowTop = snapToLenticule(rowTop);
+            rowHeight = 0;
+        }
+
+        if (cardX + size.width() > right || rowTop + size.height() > bottom) {
+            if (fillSheet) break;
+            return {};
+        }
+
+        placements.append(ImpositionPlacement{cardIndex, QRect(cardX, rowTop, size.width(), size.height())});
+        x = cardX + size.width() + gutter;
+        rowHeight = qMax(rowHeight, size.height());
+    }
+    return placements;
+}
+
+QList<QRect> SheetImposer::cropMarkRects(const QList<ImpositionPlacement>& placements) const
+{
+    QList<QRect> marks;
+    if (!settings.cropMarks) return marks;
+
+    // 裁切线长3毫米，距卡片边缘1毫米，线宽约0.1毫米
+    const int length = qMax(1, cmToPixels(0.3));
+    const int offset = qMax(1, cmToPixels(0.1));
+    const int thickness = qMax(1, cmToPixels(0.01));
+
+    for (const ImpositionPlacement& placement : placements) {
+        const QRect& r = placement.rect;
+        const int xs[2] = {r.left(), r.left() + r.width()};
+        const int ys[2] = {r.top(), r.top() + r.height()};
+        for (int cx = 0; cx < 2; ++cx) {
+            for (int cy = 0; cy < 2; ++cy) {
+                const int x = xs[cx];
+                const int y = ys[cy];
+                // 水平线位于卡片左右两侧，竖直线位于卡片上下两侧
+                const int hx = (cx == 0) ? x - offset - length : x + offset;
+                const int vy = (cy == 0) ? y - offset - length : y + offset;
+                marks.append(QRect(hx, y - thickness / 2, length, thickness));
+                marks.append(QRect(x - thickness / 2, vy, thickness, length));
+            }
+        }
+    }
+    return marks;
+}
+
+void SheetImposer::composeSheetStrip(QImage& strip, int y, const QList<QImage>& cards,
+                                     const QList<ImpositionPlacement>& placements, const QList<QRect>& marks)
+{
+    const QRect stripRect(0, y, strip.width(), strip.height());
+    strip.fill(Qt::white);
+
+    // 先画裁切线，卡片随后覆盖在上面，伸入相邻卡片的部分会被自然遮住
+    for (const QRect& mark : marks) {
+        const QRect area = mark.intersected(stripRect);
+        if (area.isEmpty()) continue;
+        for (int row = area.top(); row <= area.bottom(); ++row) {
+            QRgb* line = reinterpret_cast<QRgb*>(strip.scanLine(row - y));
+            std::fill(line + area.left(), line + area.left() + area.width(), qRgb(0, 0, 0));
+        }
+    }
+
+    for (const ImpositionPlacement& placement : placements) {
+        const QRect area = placement.rect.intersected(stripRect);
+        if (area.isEmpty()) continue;
+        const QImage& card = cards[placement.cardIndex];
+        for (int row = area.top(); row <= area.bottom(); ++row) {
+            memcpy(strip.scanLine(row - y) + area.left() * 4,
+                   card.constScanLine(row - placement.rect.top()),
+                   area.width() * 4);
+        }
+    }
+}
+
+bool SheetImposer::run(const LenticularRenderer::ProgressCallback& progress)
+{
+    if (settings.cardPaths.isEmpty()) throw std::runtime_error("没有需要拼版的卡片。");
+    if (settings.outputFormat == OutputFormat::Png) throw std::runtime_error("拼版只支持输出TIFF格式。");
+
+    const bool isCmyk = settings.outputFormat == OutputFormat::CmykTiff;
+    QColorSpace printColorSpace;
+    if (isCmyk) {
+        printColorSpace = QColorSpace::fromIccProfile(settings.outputIccProfile);
+        if (!printColorSpace.isValidTarget() || printColorSpace.colorModel() != QColorSpace::ColorModel::Cmyk) {
+            throw std::runtime_error("所选ICC配置文件不是有效的CMYK输出配置文件。");
+        }
+    }
+
+    // --- 卡片只加载一次，整张纸始终不在内存中 ---
+    if (!progress(0, QString("正在加载 %1 张卡片...").arg(settings.cardPaths.size()))) return false;
+    const QList<QImage> cards = QtConcurrent::blockingMapped(settings.cardPaths, [](const QString& path) {
+        QImageReader reader(path);
+        reader.setAutoTransform(true);
+        return reader.read().convertToFormat(QImage::Format_ARGB32);
+    });
+
+    QList<QSize> cardSizes;
+    for (int i = 0; i < cards.size(); ++i) {
+        if (cards[i].isNull()) {
+            throw std::runtime_error(QString("无法加载卡片图像:\n%1").arg(settings.cardPaths[i]).toStdString());
+        }
+        // 卡片按原像素放置，只有分辨率与纸张相同，卡片的光栅单元间距才与整张光栅板一致
+        const double cardDpiX = cards[i].dotsPerMeterX() * 0.0254;
+        const double cardDpiY = cards[i].dotsPerMeterY() * 0.0254;
+        if (std::abs(cardDpiX - settings.dpi) > maxDpiDeviation || std::abs(cardDpiY - settings.dpi) > maxDpiDeviation) {
+            throw std::runtime_error(QString("卡片的分辨率(%1 DPI)与纸张的打印分辨率(%2 DPI)不同，光栅单元无法与整张光栅板对齐:\n%3\n"
+                                             "请以相同的校准LPI和打印分辨率重新生成该卡片，或调整纸张的打印分辨率。")
+                                         .arg(QString::number(cardDpiX, 'f', 1))
+                                         .arg(QString::number(settings.dpi, 'f', 1))
+                                         .arg(settings.cardPaths[i]).toStdString());
+        }
+        cardSizes.append(cards[i].size());
+    }
+
+    const QList<ImpositionPlacement> placements = layout(cardSizes);
+    if (placements.isEmpty()) throw std::runtime_error("纸张上放不下指定的卡片，请调整纸张尺寸、留白或份数。");
+    const QList<QRect> marks = cropMarkRects(placements);
+
+    // 先写入临时文件，完成后再替换目标文件；取消或出错时写入器删除临时文件，已有的同名文件保持不变
+    const QSize sheetSize = sheetPixelSize();
+    const QString partialPath = RenderJournal::partialOutputPath(settings.savePath);
+    TiffStripWriter tiffWriter;
+    if (!tiffWriter.open(partialPath, sheetSize,
+                         isCmyk ? TiffStripWriter::ColorModel::Cmyk : TiffStripWriter::ColorModel::Rgb,
+                         settings.dpi, isCmyk ? settings.outputIccProfile : QColorSpace(QColorSpace::SRgb).iccProfile())) {
+        throw std::runtime_error(tiffWriter.errorString().toStdString());
+    }
+
+    // --- 按条带合成并直接写出 ---
+    const int bandHeight = 64;
+    const int width = sheetSize.width();
+    const int height = sheetSize.height();
+    const int maxInFlight = qMax(2, QThreadPool::globalInstance()->maxThreadCount() * 2);
+    const QString stageText = QString("正在拼版: %1 张卡片...").arg(placements.size());
+
+    QQueue<QFuture<QImage>> pending;
+    auto pendingGuard = qScopeGuard([&pending]() {
+        for (QFuture<QImage>& future : pending) future.waitForFinished();
+    });
+
+    auto finishOldestBand = [&]() {
+        QImage band = pending.head().result();
+        pending.dequeue();
+        if (band.isNull()) throw std::runtime_error("合成纸张条带时内存不足。");
+        if (!tiffWriter.writeBand(band)) throw std::runtime_error(tiffWriter.errorString().toStdString());
+    };
+
+    for (int y = 0; y < height; y += bandHeight) {
+        if (!progress(5 + static_cast<int>(y * 95.0 / height), stageText)) return false;
+
+        const int rows = qMin(bandHeight, height - y);
+        pending.enqueue(QtConcurrent::run([=]() -> QImage {
+            QImage strip(width, rows, QImage::Format_ARGB32);
+            if (strip.isNull()) return QImage();
+            composeSheetStrip(strip, y, cards, placements, marks);
+            if (!isCmyk) return strip;
+
+            strip.setColorSpace(QColorSpace::SRgb);
+            return strip.convertedToColorSpace(printColorSpace, QImage::Format_CMYK8888);
+        }));
+
+        while (pending.size() >= maxInFlight) finishOldestBand();
+    }
+    while (!pending.isEmpty()) finishOldestBand();
+
+    progress(100, stageText);
+    if (!tiffWriter.close()) throw std::runtime_error(tiffWriter.errorString().toStdString());
+    if (QFile::exists(settings.savePath)) QFile::remove(settings.savePath);
+    if (!QFile::rename(partialPath, settings.savePath)) {
+        QFile::remove(partialPath);
+        throw std::runtime_error(QString("保存拼版文件失败！请检查路径或权限。\n%1").arg(settings.savePath).toStdString());
+    }
+    return true;
+}
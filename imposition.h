@@ -0,0 +1,93 @@
+#ifndef IMPOSITION_H
+#define IMPOSITION_H
+
+#include "lenticularrenderer.h"
+
+#include <QList>
+#include <QString>
+#include <QSize>
+#include <QRect>
+#include <QImage>
+#include <QByteArray>
+
+/**
+ * @struct ImpositionSettings
+ * @brief 拼版参数：将多张已合成的光栅卡排到一张印刷纸上。
+ */
+struct ImpositionSettings {
+    QList<QString> cardPaths;       ///< 已合成的光栅卡图像，可以来自不同任务
+    int copiesPerCard = 0;          ///< 每张卡片的份数，0表示循环排列直到排满整张纸
+    double sheetWidthCm = 32.0;     ///< 纸张宽度(厘米)，默认SRA3
+    double sheetHeightCm = 45.0;    ///< 纸张高度(厘米)
+    double marginCm = 1.0;          ///< 纸张四周留白(厘米)
+    double gutterCm = 0.6;          ///< 卡片之间的间隔(厘米)
+    double dpi = 600.0;             ///< 纸张的打印分辨率，卡片按此分辨率原样放置，不重新采样
+    double lpi = 90.0;              ///< 覆盖整张纸的光栅板LPI，用于对齐光栅单元
+    bool isVertical = true;         ///< 光栅方向，与卡片的切分方向一致
+    bool isGrid = false;            ///< 是否为二维交错的卡片(微透镜阵列)，为true时卡片的X和Y都对齐到透镜间距
+    bool cropMarks = true;          ///< 是否绘制裁切线
+    QString savePath;               ///< 输出文件路径
+    OutputFormat outputFormat = OutputFormat::RgbTiff; ///< 只支持可流式写出的TIFF格式
+    QByteArray outputIccProfile;    ///< CMYK输出使用的ICC配置文件内容
+};
+
+/**
+ * @struct ImpositionPlacement
+ * @brief 一张卡片在纸张上的位置(像素坐标)。
+ */
+struct ImpositionPlacement {
+    int cardIndex;  ///< 对应cardPaths中的下标
+    QRect rect;     ///< 卡片在纸张上占据的区域
+};
+
+/**
+ * @class SheetImposer
+ * @brief 拼版器：排列卡片、绘制裁切线，并按条带将整张纸直接写入输出文件。
+ *
+ * 沿光栅间距方向，每张卡片的起点都对齐到光栅单元的整数倍，
+ * 保证一整块光栅板覆盖整张纸时，所有卡片的光栅单元都能对准。
+ */
+class SheetImposer
+{
+public:
+    /**
+     * @brief “自动排满”时最多排列的卡片数，防止极小的卡片产生过多位置。
+     */
+    static constexpr int maxFillPlacements = 1000;
+
+    explicit SheetImposer(const ImpositionSettings& settings);
+
+    /**
+     * @brief 纸张的像素尺寸。
+     */
+    QSize sheetPixelSize() const;
+
+    /**
+     * @brief 按行依次排列卡片。
+     * @param cardSizes 每张卡片的像素尺寸，与cardPaths一一对应。
+     * @return 所有卡片的位置；指定份数却放不下时返回空列表。自动排满时最多返回maxFillPlacements个位置。
+     */
+    QList<ImpositionPlacement> layout(const QList<QSize>& cardSizes) const;
+
+    /**
+     * @brief 生成整张纸并写入输出文件。
+     * @return 正常完成返回true，被取消返回false。出错时抛出std::exception。
+     */
+    bool run(const LenticularRenderer::ProgressCallback& progress);
+
+private:
+    ImpositionSettings settings;
+
+    int cmToPixels(double cm) const;
+
+    /// @brief 计算每个卡片四角的裁切线，以矩形表示。
+    QList<QRect> cropMarkRects(const QList<ImpositionPlacement>& placements) const;
+
+    /**
+     * @brief 合成纸张的一个条带：白底、裁切线，再覆盖上各卡片的对应行。
+     */
+    static void composeSheetStrip(QImage& strip, int y, const QList<QImage>& cards,
+                                  const QList<ImpositionPlacement>& placements, const QList<QRect>& marks);
+};
+
+#endif // IMPOSITION_H
@@ -0,0 +1,30 @@
+#include "interleavegrid.h"
+
+#include <QtGlobal>
+#include <cmath>
+
+InterleaveGrid InterleaveGrid::resolve(int frameCount, int gridColumns, int sliceWidth, int sliceHeight)
+{
+    InterleaveGrid grid;
+    frameCount = qMax(1, frameCount);
+    sliceWidth = qMax(1, sliceWidth);
+    grid.columns = gridColumns > 0 ? qMin(gridColumns, frameCount) : static_cast<int>(std::ceil(std::sqrt(double(frameCount))));
+    grid.rows = (frameCount + grid.columns - 1) / grid.columns;
+    if (sliceHeight > 0) {
+        grid.sliceHeight = sliceHeight;
+        return grid;
+    }
+
+    // 单元宽度能被M整除时切片高度才是整数，单元才是正方形。M不超过N时增加行数只会重复少量的帧；
+    // 自动的N不小于所需行数，M = N总能整除，因此自动矩阵总是正方形
+    const int cellWidth = sliceWidth * grid.columns;
+    for (int rows = grid.rows; rows <= grid.columns; ++rows) {
+        if (cellWidth % rows == 0) {
+            grid.rows = rows;
+            grid.sliceHeight = cellWidth / rows;
+            return grid;
+        }
+    }
+    grid.sliceHeight = qMax(1, qRound(double(cellWidth) / grid.rows));
+    return grid;
+}
@@ -0,0 +1,40 @@
+#ifndef INTERLEAVEGRID_H
+#define INTERLEAVEGRID_H
+
+#include <QSize>
+
+/**
+ * @struct InterleaveGrid
+ * @brief 二维交错(蝇眼/微透镜阵列)时每个透镜单元下的视点矩阵。
+ *
+ * 每个透镜单元由N列M行切片组成，输出图像(x, y)处的帧为矩阵中第(y / 切片高度) % M行、第(x / 切片宽度) % N列的视点。
+ * 帧按行优先填入矩阵，N×M大于帧数时多出的位置从第一帧起循环。
+ */
+struct InterleaveGrid {
+    int columns = 1;        ///< 水平方向的视点数N
+    int rows = 1;           ///< 垂直方向的视点数M
+    int sliceHeight = 1;    ///< 每个切片的像素高度
+
+    /**
+     * @brief 按帧数确定视点矩阵。
+     * @param gridColumns 指定的N，不大于0时取接近正方形的矩阵。
+     * @param sliceHeight 指定的切片高度，不大于0时使透镜单元的高度等于宽度(透镜在两个方向上间距相同)：
+     * M取不小于所需行数、且能整除单元宽度的最小值，多出的位置循环填入帧。
+     * 只有指定的N小于所需行数、且单元宽度不能被行数整除时才找不到，此时取最接近的高度，isSquare()为false。
+     */
+    static InterleaveGrid resolve(int frameCount, int gridColumns, int sliceWidth, int sliceHeight);
+
+    /// @brief 输出图像中一个切片位置的帧下标。
+    int frameAt(int sliceColumn, int sliceRow, int frameCount) const
+    {
+        return ((sliceRow % rows) * columns + sliceColumn % columns) % frameCount;
+    }
+
+    /// @brief 一个透镜单元的像素尺寸。
+    QSize cellSize(int sliceWidth) const { return QSize(sliceWidth * columns, sliceHeight * rows); }
+
+    /// @brief 透镜单元是否为正方形。
+    bool isSquare(int sliceWidth) const { return sliceHeight * rows == sliceWidth * columns; }
+};
+
+#endif // INTERLEAVEGRID_H
@@ -0,0 +1,93 @@
+#include "largebuffer.h"
+
+#include <QtGlobal>
+#include <cstdlib>
+#include <cstdint>
+
+#if defined(Q_OS_LINUX)
+#include <sys/mman.h>
+#elif defined(Q_OS_WIN)
+#include <windows.h>
+#endif
+
+namespace {
+
+/// @brief 图像释放时所需的分配信息
+struct Allocation {
+    void* data;
+    std::size_t size;
+};
+
+void releaseImageBuffer(void* info)
+{
+    Allocation* allocation = static_cast<Allocation*>(info);
+    LargeBuffer::release(allocation->data, allocation->size);
+    delete allocation;
+}
+
+} // namespace
+
+void* LargeBuffer::allocate(std::size_t size)
+{
+    if (size == 0) return nullptr;
+
+#if defined(Q_OS_LINUX)
+    // 多映射一个大页再裁掉两端，使起始地址按2MB对齐，整段都能使用透明大页
+    const std::size_t mappedSize = size + hugePageSize;
+    void* mapped = mmap(nullptr, mappedSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mapped == MAP_FAILED) return nullptr;
+
+    const std::uintptr_t begin = reinterpret_cast<std::uintptr_t>(mapped);
+    const std::uintptr_t aligned = (begin + hugePageSize - 1) & ~std::uintptr_t(hugePageSize - 1);
+    const std::size_t head = aligned - begin;
+    const std::size_t tail = mappedSize - head - size;
+    if (head > 0) munmap(mapped, head);
+    if (tail > 0) munmap(reinterpret_cast<void*>(aligned + size), tail);
+
+    void* data = reinterpret_cast<void*>(aligned);
+#ifdef MADV_HUGEPAGE
+    madvise(data, size, MADV_HUGEPAGE);
+#endif
+    return data;
+#elif defined(Q_OS_WIN)
+    return VirtualAlloc(nullptr, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+#else
+    return std::malloc(size);
+#endif
+}
+
+void LargeBuffer::release(void* data, std::size_t size)
+{
+    if (!data) return;
+#if defined(Q_OS_LINUX)
+    munmap(data, size);
+#elif defined(Q_OS_WIN)
+    Q_UNUSED(size);
+    VirtualFree(data, 0, MEM_RELEASE);
+#else
+    Q_UNUSED(size);
+    std::free(data);
+#endif
+}
+
+QImage LargeBuffer::createImage(const QSize& size, QImage::Format format)
+{
+    if (size.isEmpty()) return QImage();
+
+    // 每行按32位对齐，与QImage自行分配时一致
+    const int depth = QImage::toPixelFormat(format).bitsPerPixel();
+    const qsizetype bytesPerLine = ((qsizetype(size.width()) * depth + 31) / 32) * 4;
+    const std::size_t bytes = std::size_t(bytesPerLine) * size.height();
+
+    void* data = allocate(bytes);
+    if (!data) return QImage();
+
+    Allocation* allocation = new Allocation{data, bytes};
+    QImage image(static_cast<uchar*>(data), size.width(), size.height(), bytesPerLine, format,
+                 releaseImageBuffer, allocation);
+    if (image.isNull()) {
+        releaseImageBuffer(allocation);
+        return QImage();
+    }
+    return image;
+}
@@ -0,0 +1,39 @@
+#ifndef LARGEBUFFER_H
+#define LARGEBUFFER_H
+
+#include <QImage>
+#include <QSize>
+#include <cstddef>
+
+/**
+ * @class LargeBuffer
+ * @brief 大幅结果图的内存分配：尽量使用2MB大页，并让每个条带的内存落在合成它的线程所在的NUMA节点上。
+ *
+ * 内存直接向系统申请，分配时不写入任何数据。操作系统在第一次写入时才分配物理页，
+ * 并放在写入线程所在的节点上；结果图的每个条带由线程池中的某个线程第一次写入，
+ * 因此条带的内存自然落在合成它的线程附近，之后该条带的读写不再跨节点。
+ * Linux上通过madvise(MADV_HUGEPAGE)请求透明大页，减少TLB缺失；Windows的大页需要特殊权限且必须立即提交，
+ * 因此只使用普通页，仍然保留首次写入分配的行为。其他系统退回到普通的图像分配。
+ */
+class LargeBuffer
+{
+public:
+    /**
+     * @brief 创建由LargeBuffer分配内存的图像，图像(及其所有共享副本)销毁时自动释放内存。
+     * 图像内容未初始化。分配失败时返回空图像。
+     */
+    static QImage createImage(const QSize& size, QImage::Format format);
+
+    /**
+     * @brief 分配size字节，不写入内存。失败时返回nullptr。
+     */
+    static void* allocate(std::size_t size);
+
+    /// @brief 释放allocate()分配的内存，size必须与分配时相同。
+    static void release(void* data, std::size_t size);
+
+    /// @brief 大页的大小。
+    static constexpr std::size_t hugePageSize = std::size_t(2) * 1024 * 1024;
+};
+
+#endif // LARGEBUFFER_H
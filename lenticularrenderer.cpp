@@ -0,0 +1,909 @@
+#include "lenticularrenderer.h"
+#include "tiffwriter.h"
+#include "pdfwriter.h"
+#include "renderjournal.h"
+#include "scratchframe.h"
+#include "bandprefetcher.h"
+#include "framecache.h"
+#include "frameregistration.h"
+#include "largebuffer.h"
+#include "framesharpener.h"
+#include "linearscaler.h"
+
+#include <QFile>
+#include <QFileInfo>
+#include <QImageReader>
+#include <QHash>
+#include <QCryptographicHash>
+#include <QJsonArray>
+#include <QPainter>
+#include <QThreadPool>
+#include <QQueue>
+#include <QFuture>
+#include <QtConcurrent/QtConcurrentRun>
+#include <QtConcurrent/QtConcurrentMap>
+#include <QDebug>
+#include <memory>
+#include <algorithm>
+#include <vector>
+#include <stdexcept>
+#include <cstring>
+#include <cmath>
+
+namespace {
+
+/// @brief 阶段二预读的条带数：读取线程在合成当前条带时读好下一个条带
+constexpr int prefetchDepth = 2;
+
+/// @brief 合成完成的条带。PDF输出在线程池中压缩好，只保留压缩后的数据
+struct CompositedBand {
+    QImage strip;
+    QByteArray encoded;
+    int rows = 0;
+};
+
+/// @brief 阶段二中单个输出目标的状态
+struct TargetState {
+    int index = 0;                  // 在settings.targets中的下标
+    RenderTarget target;
+    QList<ScratchFrameFile*> frameFiles; // 该目标各帧的临时文件
+    QList<QImage> cachedFrames;     // 全部帧都来自缓存时直接读取的缩放帧，此时不打开临时文件
+    QImage resultImage;             // PNG: 整幅结果图
+    uchar* resultBits = nullptr;
+    qsizetype resultBytesPerLine = 0;
+    TiffStripWriter tiffWriter;     // TIFF: 流式写出
+    PdfStripWriter pdfWriter;       // PDF: 流式写出
+    QQueue<QFuture<CompositedBand>> pending;
+    int nextRow = 0;                // 下一个待提交的行
+    int completedRows = 0;          // 已写出并记入日志的行数
+
+    ~TargetState()
+    {
+        // 必须先等待仍在引用resultImage的任务结束
+        for (QFuture<CompositedBand>& future : pending) future.waitForFinished();
+        qDeleteAll(frameFiles);
+        // 未完成的TIFF和PDF保留已写入的行，供续接使用
+        tiffWriter.suspend();
+        pdfWriter.suspend();
+    }
+};
+
+/**
+ * @brief 找出内容相同的源文件，返回每帧第一个内容与其相同的帧下标。
+ *
+ * 指向同一文件的路径直接视为相同；只有大小与其他文件相同的文件才需要读取全部内容计算哈希。
+ * @param variants 与paths对应，内容相同但variants不同的帧(如画面调整不同)不视为相同。
+ */
+QList<int> findIdenticalSources(const QList<QString>& paths, const QList<QString>& variants)
+{
+    QList<QString> canonicalPaths;
+    QHash<QString, qint64> sizeOfPath;
+    QHash<qint64, int> pathCountOfSize;
+    for (const QString& path : paths) {
+        const QFileInfo info(path);
+        const QString canonical = info.canonicalFilePath().isEmpty() ? info.absoluteFilePath() : info.canonicalFilePath();
+        canonicalPaths.append(canonical);
+        if (sizeOfPath.contains(canonical)) continue;
+        sizeOfPath.insert(canonical, info.size());
+        ++pathCountOfSize[info.size()];
+    }
+
+    QList<QString> pathsToHash;
+    for (auto it = sizeOfPath.cbegin(); it != sizeOfPath.cend(); ++it) {
+        if (pathCountOfSize.value(it.value()) > 1) pathsToHash.append(it.key());
+    }
+    const QList<QByteArray> hashes = QtConcurrent::blockingMapped(pathsToHash, [](const QString& path) {
+        QFile file(path);
+        QCryptographicHash hash(QCryptographicHash::Sha256);
+        if (!file.open(QIODevice::ReadOnly) || !hash.addData(&file)) return QByteArray();
+        return hash.result();
+    });
+
+    // 无法读取的文件只按路径区分，解码时再报错
+    QHash<QString, QByteArray> identityOfPath;
+    for (qsizetype i = 0; i < pathsToHash.size(); ++i) {
+        if (!hashes[i].isEmpty()) identityOfPath.insert(pathsToHash[i], hashes[i]);
+    }
+
+    QList<int> representatives;
+    QHash<QByteArray, int> firstFrameOfIdentity;
+    for (int i = 0; i < paths.size(); ++i) {
+        const QByteArray identity = identityOfPath.value(canonicalPaths[i], canonicalPaths[i].toUtf8()) + '|' + variants[i].toUtf8();
+        if (!firstFrameOfIdentity.contains(identity)) firstFrameOfIdentity.insert(identity, i);
+        representatives.append(firstFrameOfIdentity.value(identity));
+    }
+    return representatives;
+}
+
+/**
+ * @brief 为一帧建立缩放金字塔：从原图开始逐级减半，直到再减半就小于最小的目标尺寸。
+ */
+QList<QImage> buildPyramid(const QImage& original, const QSize& smallestTarget)
+{
+    QList<QImage> levels{original};
+    while (true) {
+        const QSize half(levels.last().width() / 2, levels.last().height() / 2);
+        if (half.width() < smallestTarget.width() || half.height() < smallestTarget.height()) break;
+
+        QImage level = levels.last().scaled(half, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+        if (level.isNull()) throw std::runtime_error("在缩放图像时内存不足。");
+        levels.append(level);
+    }
+    return levels;
+}
+
+/**
+ * @brief 选出金字塔中不小于目标尺寸的最小一级，目标从这一级缩放得到。
+ */
+const QImage& pickPyramidLevel(const QList<QImage>& levels, const QSize& targetSize)
+{
+    for (qsizetype i = levels.size() - 1; i > 0; --i) {
+        if (levels[i].width() >= targetSize.width() && levels[i].height() >= targetSize.height()) {
+            return levels[i];
+        }
+    }
+    return levels.first();
+}
+
+/**
+ * @brief 串扰补偿的内核：逐字节计算(c*wc - (p + n)*wn) / 65536并截断到0~255。
+ *
+ * 循环体只有整数乘加和截断，没有分支和跨字节依赖，编译器可以自动向量化。
+ * 四个通道统一处理，不透明像素的Alpha经补偿后仍为255。
+ */
+void compensateCrosstalk(uchar* __restrict out, const uchar* __restrict center,
+                         const uchar* __restrict previous, const uchar* __restrict next,
+                         qsizetype count, int centerWeight, int neighborWeight)
+{
+    for (qsizetype i = 0; i < count; ++i) {
+        const int value = (center[i] * centerWeight - (previous[i] + next[i]) * neighborWeight + 32768) >> 16;
+        out[i] = static_cast<uchar>(qBound(0, value, 255));
+    }
+}
+
+/**
+ * @brief 二维交错的行复制内核：把一帧的一行中属于同一视点列的各个切片复制到输出行。
+ *
+ * 这些切片在行中以透镜单元宽度为间隔重复出现，逐个视点列处理时每次只读一帧的数据。
+ * 以32位像素为单位复制，切片很窄(微透镜阵列常为1~2像素)时没有memcpy调用的开销，切片较宽时内层循环可以自动向量化。
+ * @param firstX 该视点列第一个切片的起点。
+ */
+void copyGridSlices(quint32* __restrict out, const quint32* __restrict source, int width,
+                    int firstX, int sliceWidth, int cellWidth)
+{
+    for (int x = firstX; x < width; x += cellWidth) {
+        const int end = qMin(x + sliceWidth, width);
+        for (int p = x; p < end; ++p) out[p] = source[p];
+    }
+}
+
+/**
+ * @brief 把各帧覆盖条带的行按切片位置展开，并在相邻两个位置之间合成中间帧。
+ * @param frameRows 每个不同的帧一段连续的行，条带从其中第bandOffset行开始，块匹配时上下可能多出相邻的行。
+ * @return 按最终帧顺序排列的条带数据；内存不足时返回空列表。
+ */
+QList<QByteArray> expandBandSources(const QList<QByteArray>& frameRows, int width, int bandOffset, int rows,
+                                    const QList<int>& slotSources, int inBetween, InterpolationMode mode)
+{
+    const qsizetype bytesPerLine = qsizetype(width) * 4;
+    const int totalRows = static_cast<int>(frameRows.first().size() / bytesPerLine);
+    QList<QByteArray> bands;
+    for (const QByteArray& rowsOfFrame : frameRows) {
+        bands.append(totalRows == rows ? rowsOfFrame : rowsOfFrame.mid(bandOffset * bytesPerLine, rows * bytesPerLine));
+    }
+
+    // 重复的位置只是共享同一份数据，不复制像素
+    QList<QByteArray> sources;
+    for (qsizetype s = 0; s < slotSources.size(); ++s) {
+        const int f = slotSources[s];
+        sources.append(bands[f]);
+        if (inBetween <= 0 || s + 1 >= slotSources.size()) continue;
+
+        const int next = slotSources[s + 1];
+        if (next == f) {
+            // 停留的帧之间没有变化，中间帧就是该帧本身
+            for (int k = 0; k < inBetween; ++k) sources.append(bands[f]);
+            continue;
+        }
+        const QList<QByteArray> synthesized = FrameInterpolator::synthesizeBand(
+            reinterpret_cast<const uchar*>(frameRows[f].constData()), reinterpret_cast<const uchar*>(frameRows[next].constData()),
+            width, totalRows, bandOffset, rows, inBetween, mode);
+        if (synthesized.isEmpty()) return {};
+        sources.append(synthesized);
+    }
+    return sources;
+}
+
+/**
+ * @brief 解码一个条带中各帧的数据，按切片位置展开，并在相邻两个位置之间合成中间帧。在线程池中调用。
+ * @param storedBlocks 预读的存储数据，每个不同的帧blockCount个连续的块，从firstBlock开始。
+ * 块匹配时多读条带上下各一块，运动向量可以指向条带之外。
+ * @param slotSources 每个切片位置使用的帧。同一帧只解码一次，各位置共享解码后的数据。
+ * @return 按最终帧顺序排列的条带数据；数据损坏或内存不足时返回空列表。
+ */
+QList<QByteArray> decodeBandSources(const QList<QByteArray>& storedBlocks, ScratchCodec codec, int width, int height,
+                                    int firstBlock, int blockCount, int y, int rows,
+                                    const QList<int>& slotSources, int inBetween, InterpolationMode mode)
+{
+    const int bandHeight = ScratchFrameFile::blockRows;
+    const qsizetype bytesPerLine = qsizetype(width) * 4;
+    const int uniqueCount = storedBlocks.size() / blockCount;
+
+    QList<QByteArray> frameRows;
+    for (int f = 0; f < uniqueCount; ++f) {
+        QByteArray rowsOfFrame;
+        for (int j = 0; j < blockCount; ++j) {
+            const int rowsInBlock = qMin(bandHeight, height - (firstBlock + j) * bandHeight);
+            const QByteArray decoded = ScratchFrameFile::decodeBlock(storedBlocks[f * blockCount + j], codec, rowsInBlock * bytesPerLine);
+            if (decoded.isEmpty()) return {};
+            rowsOfFrame.append(decoded);
+        }
+        frameRows.append(rowsOfFrame);
+    }
+    return expandBandSources(frameRows, width, y - firstBlock * bandHeight, rows, slotSources, inBetween, mode);
+}
+
+/**
+ * @brief 与decodeBandSources相同，但各帧的数据直接取自内存中缓存的缩放帧，不经过临时文件。在线程池中调用。
+ * @param frames 每个不同的帧一幅ARGB32图像，调用方须在返回的数据使用完之前保持这些图像存活。
+ */
+QList<QByteArray> bandSourcesFromImages(const QList<QImage>& frames, int width, int height,
+                                        int firstBlock, int blockCount, int y, int rows,
+                                        const QList<int>& slotSources, int inBetween, InterpolationMode mode)
+{
+    const int bandHeight = ScratchFrameFile::blockRows;
+    const qsizetype bytesPerLine = qsizetype(width) * 4;
+    const int firstRow = firstBlock * bandHeight;
+    const int rowCount = qMin(blockCount * bandHeight, height - firstRow);
+
+    // ARGB32图像的各行首尾相接，直接引用所需的行，不复制像素
+    QList<QByteArray> frameRows;
+    for (const QImage& frame : frames) {
+        frameRows.append(QByteArray::fromRawData(reinterpret_cast<const char*>(frame.constScanLine(firstRow)), rowCount * bytesPerLine));
+    }
+    return expandBandSources(frameRows, width, y - firstRow, rows, slotSources, inBetween, mode);
+}
+
+} // namespace
+
+QJsonObject renderSettingsToJson(const RenderSettings& settings)
+{
+    QJsonArray targets;
+    for (const RenderTarget& target : settings.targets) {
+        targets.append(QJsonObject{{"width", target.imageSize.width()},
+                                   {"height", target.imageSize.height()},
+                                   {"savePath", target.savePath}});
+    }
+
+    const char* format = "png";
+    if (settings.outputFormat == OutputFormat::CmykTiff) format = "cmykTiff";
+    if (settings.outputFormat == OutputFormat::RgbTiff) format = "rgbTiff";
+    if (settings.outputFormat == OutputFormat::CmykPdf) format = "cmykPdf";
+    if (settings.outputFormat == OutputFormat::RgbPdf) format = "rgbPdf";
+
+    QJsonObject json;
+    json["imagePaths"] = QJsonArray::fromStringList(settings.imagePaths);
+    QJsonArray frameHolds;
+    for (int hold : settings.frameHolds) frameHolds.append(hold);
+    json["frameHolds"] = frameHolds;
+    QJsonArray frameTransforms;
+    for (const FrameTransform& transform : settings.frameTransforms) frameTransforms.append(transform.toJson());
+    json["frameTransforms"] = frameTransforms;
+    json["targets"] = targets;
+    json["isVertical"] = settings.isVertical;
+    json["sliceWidth"] = settings.sliceWidth;
+    json["isGrid"] = settings.isGrid;
+    json["gridColumns"] = settings.gridColumns;
+    json["sliceHeight"] = settings.sliceHeight;
+    json["outputDpi"] = settings.outputDpi;
+    json["outputFormat"] = format;
+    json["scratchCodec"] = (settings.scratchCodec == ScratchCodec::Deflate) ? "deflate" : "raw";
+    json["alignFrames"] = settings.alignFrames;
+    json["crosstalk"] = settings.crosstalk;
+    json["inBetweenFrames"] = settings.inBetweenFrames;
+    json["interpolation"] = (settings.interpolation == InterpolationMode::BlockMatching) ? "blockMatching" : "crossFade";
+    json["sharpenAmount"] = settings.sharpenAmount;
+    json["sharpenRadius"] = settings.sharpenRadius;
+    json["linearLightScaling"] = settings.linearLightScaling;
+    json["largePageBuffers"] = settings.largePageBuffers;
+    json["outputIccProfile"] = QString::fromLatin1(settings.outputIccProfile.toBase64());
+    return json;
+}
+
+RenderSettings renderSettingsFromJson(const QJsonObject& json)
+{
+    RenderSettings settings;
+    for (const QJsonValue& path : json["imagePaths"].toArray()) {
+        settings.imagePaths.append(path.toString());
+    }
+    for (const QJsonValue& hold : json["frameHolds"].toArray()) {
+        settings.frameHolds.append(hold.toInt(1));
+    }
+    for (const QJsonValue& transform : json["frameTransforms"].toArray()) {
+        settings.frameTransforms.append(FrameTransform::fromJson(transform.toObject()));
+    }
+    for (const QJsonValue& value : json["targets"].toArray()) {
+        const QJsonObject target = value.toObject();
+        settings.targets.append(RenderTarget{QSize(target["width"].toInt(), target["height"].toInt()),
+                                             target["savePath"].toString()});
+    }
+    settings.isVertical = json["isVertical"].toBool(settings.isVertical);
+    settings.sliceWidth = json["sliceWidth"].toInt(settings.sliceWidth);
+    settings.isGrid = json["isGrid"].toBool(settings.isGrid);
+    settings.gridColumns = json["gridColumns"].toInt(settings.gridColumns);
+    settings.sliceHeight = json["sliceHeight"].toInt(settings.sliceHeight);
+    settings.outputDpi = json["outputDpi"].toDouble(settings.outputDpi);
+
+    const QString format = json["outputFormat"].toString();
+    if (format == "cmykTiff") settings.outputFormat = OutputFormat::CmykTiff;
+    if (format == "rgbTiff") settings.outputFormat = OutputFormat::RgbTiff;
+    if (format == "cmykPdf") settings.outputFormat = OutputFormat::CmykPdf;
+    if (format == "rgbPdf") settings.outputFormat = OutputFormat::RgbPdf;
+    settings.alignFrames = json["alignFrames"].toBool(settings.alignFrames);
+    settings.crosstalk = json["crosstalk"].toDouble(settings.crosstalk);
+    settings.inBetweenFrames = qMax(0, json["inBetweenFrames"].toInt(settings.inBetweenFrames));
+    if (json["interpolation"].toString() == "blockMatching") settings.interpolation = InterpolationMode::BlockMatching;
+    settings.sharpenAmount = json["sharpenAmount"].toDouble(settings.sharpenAmount);
+    settings.sharpenRadius = json["sharpenRadius"].toDouble(settings.sharpenRadius);
+    // 较早的任务没有这一字段，取默认值(关闭)即沿用当时的sRGB缩放，与已完成的帧保持一致
+    settings.linearLightScaling = json["linearLightScaling"].toBool(settings.linearLightScaling);
+    settings.largePageBuffers = json["largePageBuffers"].toBool(settings.largePageBuffers);
+    settings.outputIccProfile = QByteArray::fromBase64(json["outputIccProfile"].toString().toLatin1());
+    if (json.contains("scratchCodec")) {
+        settings.scratchCodec = (json["scratchCodec"].toString() == "raw") ? ScratchCodec::Raw : ScratchCodec::Deflate;
+    }
+    return settings;
+}
+
+QList<int> frameSlotSequence(const QList<int>& frameHolds, int frameCount)
+{
+    QList<int> sequence;
+    for (int i = 0; i < frameCount; ++i) {
+        const int hold = i < frameHolds.size() ? qMax(1, frameHolds[i]) : 1;
+        for (int k = 0; k < hold; ++k) sequence.append(i);
+    }
+    return sequence;
+}
+
+LenticularRenderer::LenticularRenderer(const RenderSettings& settings)
+    : settings(settings)
+{}
+
+bool LenticularRenderer::run(const ProgressCallback& progress)
+{
+    if (settings.imagePaths.isEmpty() || settings.targets.isEmpty()) {
+        throw std::runtime_error("没有可渲染的图像或输出目标。");
+    }
+
+    // CMYK输出需要一个有效的CMYK目标色彩空间，在耗时的预处理之前检查
+    if (settings.outputFormat == OutputFormat::CmykTiff || settings.outputFormat == OutputFormat::CmykPdf) {
+        printColorSpace = QColorSpace::fromIccProfile(settings.outputIccProfile);
+        if (!printColorSpace.isValidTarget() || printColorSpace.colorModel() != QColorSpace::ColorModel::Cmyk) {
+            throw std::runtime_error("所选ICC配置文件不是有效的CMYK输出配置文件。");
+        }
+    }
+
+    // 工作目录在取消或出错后保留，相同的任务再次运行时从检查点继续
+    RenderJournal journal(settings);
+    journal.open();
+    qDebug() << "使用工作目录:" << journal.workDirPath();
+
+    const QList<QList<QString>> scaledFramePaths = preprocessFrames(journal, progress);
+    if (scaledFramePaths.isEmpty()) return false;
+
+    if (!compositeTargets(journal, scaledFramePaths, progress)) return false;
+
+    journal.finish();
+    return true;
+}
+
+QList<QList<QString>> LenticularRenderer::preprocessFrames(RenderJournal& journal, const ProgressCallback& progress)
+{
+    // 重复导入或内容相同的帧只处理一次，临时文件和阶段一的耗时只与不同的帧数有关
+    if (!progress(0, "正在处理1/2: 查找内容相同的帧...")) return {};
+    QList<QString> transformKeys;
+    for (int i = 0; i < settings.imagePaths.size(); ++i) {
+        transformKeys.append(settings.frameTransforms.value(i).cacheKey());
+    }
+    const QList<int> representatives = findIdenticalSources(settings.imagePaths, transformKeys);
+    uniqueSources.clear();
+    QHash<int, int> uniqueIndexOfFrame;
+    for (int i = 0; i < representatives.size(); ++i) {
+        if (representatives[i] != i) continue;
+        uniqueIndexOfFrame.insert(i, uniqueSources.size());
+        uniqueSources.append(i);
+    }
+    slotSources.clear();
+    for (int i : frameSlotSequence(settings.frameHolds, settings.imagePaths.size())) {
+        slotSources.append(uniqueIndexOfFrame.value(representatives[i]));
+    }
+
+    QList<QString> sourcePaths;
+    QList<FrameTransform> sourceTransforms;
+    for (int i : uniqueSources) {
+        sourcePaths.append(settings.imagePaths[i]);
+        sourceTransforms.append(settings.frameTransforms.value(i));
+    }
+    const int frameCount = sourcePaths.size();
+    const int targetCount = settings.targets.size();
+
+    // 所有目标中最小的尺寸，决定缩放金字塔建到哪一级
+    QSize smallestTarget = settings.targets.first().imageSize;
+    for (const RenderTarget& target : settings.targets) {
+        smallestTarget = smallestTarget.boundedTo(target.imageSize);
+    }
+
+    QList<QList<QString>> scaledFramePaths(targetCount);
+    const QString scratchSuffix = (settings.scratchCodec == ScratchCodec::Deflate) ? "gmz" : "raw";
+    for (int t = 0; t < targetCount; ++t) {
+        for (int i = 0; i < frameCount; ++i) {
+            scaledFramePaths[t].append(journal.workDirPath() + QString("/scaled_%1_%2.%3").arg(t).arg(i).arg(scratchSuffix));
+        }
+    }
+
+    // 检查点中已完成且文件完整的帧直接复用，已保存的目标不再需要缩放帧
+    QList<QList<int>> pendingTargetsOfFrame(frameCount);
+    bool hasPendingFrames = false;
+    for (int i = 0; i < frameCount; ++i) {
+        for (int t = 0; t < targetCount; ++t) {
+            if (journal.isSaved(t)) continue;
+            if (journal.hasFrame(t, i)
+                && ScratchFrameFile::isComplete(scaledFramePaths[t][i], settings.targets[t].imageSize, settings.scratchCodec)) {
+                continue;
+            }
+            pendingTargetsOfFrame[i].append(t);
+            hasPendingFrames = true;
+        }
+    }
+
+    // 对齐偏移在缩小的图像上估计，随后在缩放时一并应用，不额外处理全分辨率图像。
+    // 估计时与缩放时一样按各帧的设置摆正，偏移的坐标轴才与对齐区域一致
+    QList<QPointF> frameOffsets;
+    if (settings.alignFrames && hasPendingFrames) {
+        if (!progress(0, QString("正在处理1/2: 对齐各帧 (共 %1 张)").arg(frameCount))) return {};
+        QList<bool> exifOrientations;
+        for (const FrameTransform& transform : sourceTransforms) exifOrientations.append(transform.exifOrientation);
+        frameOffsets = FrameAligner::estimateOffsets(sourcePaths, exifOrientations);
+    }
+
+    // 缓存命中的帧先留在内存中：一个目标的全部帧都命中时，阶段二直接读取缓存的图像，不写临时文件再读回
+    QList<QList<QImage>> cachedFrames(targetCount, QList<QImage>(frameCount));
+    const QString phaseOneText = QString("正在处理1/2: 预处理源图像 (共 %1 张)").arg(frameCount);
+    for (int i = 0; i < frameCount; ++i) {
+        if (!progress(static_cast<int>((i * 1.0 / frameCount) * 50.0), phaseOneText)) return {};
+
+        const QList<int>& pendingTargets = pendingTargetsOfFrame[i];
+        if (pendingTargets.isEmpty()) continue;
+
+        // 缓存中已有缩放好的帧时不再缩放
+        const QString sourceKey = frameCache ? FrameCache::sourceKey(sourcePaths[i]) : QString();
+        // 对齐后的缩放帧与取景区域有关，区域(按十万分之一取整)计入缓存键
+        QString scaledKey = sourceKey;
+        if (!frameOffsets.isEmpty() && !sourceKey.isEmpty()) {
+            const QRect cropKey = FrameAligner::alignedSourceRect(QSize(100000, 100000), frameOffsets, i).toRect();
+            scaledKey += QString("|%1,%2,%3,%4").arg(cropKey.x()).arg(cropKey.y()).arg(cropKey.width()).arg(cropKey.height());
+        }
+        if (settings.sharpenAmount > 0.0 && !sourceKey.isEmpty()) {
+            scaledKey += QString("|sharpen %1,%2").arg(settings.sharpenAmount).arg(settings.sharpenRadius);
+        }
+        if (settings.linearLightScaling && !sourceKey.isEmpty()) scaledKey += "|linear";
+        const FrameTransform& transform = sourceTransforms[i];
+        if (!transform.isIdentity() && !sourceKey.isEmpty()) scaledKey += "|" + transform.cacheKey();
+        QList<int> targetsToScale;
+        for (int t : pendingTargets) {
+            const QImage cachedImg = frameCache ? frameCache->scaledFrame(scaledKey, settings.targets[t].imageSize) : QImage();
+            if (cachedImg.isNull()) {
+                targetsToScale.append(t);
+                continue;
+            }
+            cachedFrames[t][i] = cachedImg.convertToFormat(QImage::Format_ARGB32);
+        }
+        if (targetsToScale.isEmpty()) continue;
+
+        // 有画面调整的帧只解码取景区域，调整与对齐、缩放在同一次重采样中完成，不生成全尺寸的中间图像
+        QList<QImage> transformedImgs;
+        QList<QImage> pyramid;
+        if (!transform.isIdentity()) {
+            const QRectF alignedRect = frameOffsets.isEmpty() ? QRectF(0.0, 0.0, 1.0, 1.0)
+                                                              : FrameAligner::alignedSourceRect(QSize(1, 1), frameOffsets, i);
+            QList<QSize> targetSizes;
+            for (int t : targetsToScale) targetSizes.append(settings.targets[t].imageSize);
+            transformedImgs = FrameTransformer::render(sourcePaths[i], transform, alignedRect, targetSizes, settings.linearLightScaling);
+        } else {
+            // 每帧只解码一次
+            QImage originalImg = frameCache ? frameCache->decodedFrame(sourceKey) : QImage();
+            if (originalImg.isNull()) {
+                // 按EXIF方向摆正，与FrameTransform的默认值和界面计算尺寸的方式一致
+                QImageReader reader(sourcePaths[i]);
+                reader.setAutoTransform(true);
+                originalImg = reader.read();
+                if (originalImg.isNull()) throw std::runtime_error("无法加载源文件。");
+                if (frameCache) frameCache->insertDecodedFrame(sourceKey, originalImg);
+            }
+
+            // 多个目标时，每个目标从金字塔中最接近的一级缩放，而不是每次都从原图缩放。
+            // 对齐时的缩放是双线性插值，也从金字塔中不超过两倍的一级开始，避免大比例缩小产生锯齿。
+            // 线性光缩放的滤波器本身覆盖全部源像素，而金字塔是在sRGB中逐级缩小的，因此直接从原图缩放
+            const bool needsPyramid = !settings.linearLightScaling && (targetsToScale.size() > 1 || !frameOffsets.isEmpty());
+            pyramid = needsPyramid ? buildPyramid(originalImg, smallestTarget) : QList<QImage>{originalImg};
+        }
+
+        for (qsizetype k = 0; k < targetsToScale.size(); ++k) {
+            const int t = targetsToScale[k];
+            const QSize targetSize = settings.targets[t].imageSize;
+            QImage scaledImg;
+            if (!transformedImgs.isEmpty()) {
+                scaledImg = transformedImgs[k];
+            } else if (settings.linearLightScaling) {
+                const QImage& original = pyramid.first();
+                const QRectF sourceRect = frameOffsets.isEmpty() ? QRectF(QPointF(0, 0), QSizeF(original.size()))
+                                                                 : FrameAligner::alignedSourceRect(original.size(), frameOffsets, i, targetSize);
+                scaledImg = LinearLightScaler::scale(original, sourceRect, targetSize);
+            } else if (frameOffsets.isEmpty()) {
+                const QImage& level = pickPyramidLevel(pyramid, targetSize);
+                scaledImg = level.scaled(targetSize, Qt::IgnoreAspectRatio, Qt::SmoothTransformation)
+                                 .convertToFormat(QImage::Format_ARGB32);
+            } else {
+                // 取各帧共有的画面区域(居中裁切为目标的宽高比)并按偏移平移，平移和缩放在同一次重采样中完成
+                const QImage& level = pickPyramidLevel(pyramid, targetSize);
+                scaledImg = QImage(targetSize, QImage::Format_ARGB32);
+                if (!scaledImg.isNull()) {
+                    QPainter painter(&scaledImg);
+                    painter.setCompositionMode(QPainter::CompositionMode_Source);
+                    painter.setRenderHint(QPainter::SmoothPixmapTransform);
+                    painter.drawImage(QRectF(QPointF(0, 0), QSizeF(targetSize)), level,
+                                      FrameAligner::alignedSourceRect(level.size(), frameOffsets, i, targetSize));
+                }
+            }
+            if (scaledImg.isNull()) throw std::runtime_error("在缩放图像时内存不足。");
+
+            // 锐化紧接着缩放在内存中进行，帧写入临时文件时已经锐化，不需要再读写一遍
+            if (settings.sharpenAmount > 0.0) {
+                scaledImg = FrameSharpener::apply(scaledImg, settings.sharpenAmount, settings.sharpenRadius);
+                if (scaledImg.isNull()) throw std::runtime_error("在锐化图像时内存不足。");
+            }
+
+            ScratchFrameFile::write(scaledFramePaths[t][i], scaledImg, settings.scratchCodec);
+            journal.markFrame(t, i);
+            if (frameCache) frameCache->insertScaledFrame(scaledKey, targetSize, scaledImg);
+        }
+    }
+
+    // 只有部分帧命中缓存的目标仍从临时文件读取，命中的帧在这里补写
+    cachedTargetFrames = QList<QList<QImage>>(targetCount);
+    for (int t = 0; t < targetCount; ++t) {
+        const bool allCached = std::all_of(cachedFrames[t].cbegin(), cachedFrames[t].cend(),
+                                           [](const QImage& frame) { return !frame.isNull(); });
+        if (allCached) {
+            cachedTargetFrames[t] = cachedFrames[t];
+            continue;
+        }
+        for (int i = 0; i < frameCount; ++i) {
+            if (cachedFrames[t][i].isNull()) continue;
+            ScratchFrameFile::write(scaledFramePaths[t][i], cachedFrames[t][i], settings.scratchCodec);
+            journal.markFrame(t, i);
+        }
+    }
+    return scaledFramePaths;
+}
+
+bool LenticularRenderer::compositeTargets(RenderJournal& journal, const QList<QList<QString>>& scaledFramePaths, const ProgressCallback& progress)
+{
+    const bool isTiff = settings.outputFormat == OutputFormat::CmykTiff || settings.outputFormat == OutputFormat::RgbTiff;
+    const bool isPdf = settings.outputFormat == OutputFormat::CmykPdf || settings.outputFormat == OutputFormat::RgbPdf;
+    const bool isCmyk = settings.outputFormat == OutputFormat::CmykTiff || settings.outputFormat == OutputFormat::CmykPdf;
+    const PdfStripWriter::ColorModel pdfColorModel = isCmyk ? PdfStripWriter::ColorModel::Cmyk : PdfStripWriter::ColorModel::Rgb;
+    const bool isVertical = settings.isVertical;
+    const int sliceWidth = settings.sliceWidth;
+    const double crosstalk = settings.crosstalk;
+    const int inBetween = settings.inBetweenFrames;
+    const QList<int> frameOfSlot = slotSources;
+    const InterpolationMode interpolation = settings.interpolation;
+    const QColorSpace colorSpace = printColorSpace;
+    const ScratchCodec scratchCodec = settings.scratchCodec;
+    const int targetCount = settings.targets.size();
+    const int bandHeight = ScratchFrameFile::blockRows;
+    const bool isGrid = settings.isGrid;
+    const InterleaveGrid grid = InterleaveGrid::resolve(FrameInterpolator::totalFrameCount(frameOfSlot.size(), inBetween),
+                                                        settings.gridColumns, sliceWidth, settings.sliceHeight);
+
+    // 为每个尚未保存的目标打开临时文件，并从检查点恢复已合成的行
+    std::vector<std::unique_ptr<TargetState>> states;
+    qint64 totalRows = 0;
+    for (int t = 0; t < targetCount; ++t) {
+        if (journal.isSaved(t)) continue;
+
+        auto state = std::make_unique<TargetState>();
+        state->index = t;
+        state->target = settings.targets[t];
+        state->cachedFrames = cachedTargetFrames.value(t);
+
+        for (const QString& path : scaledFramePaths[t]) {
+            if (!state->cachedFrames.isEmpty()) break;
+            ScratchFrameFile* file = new ScratchFrameFile();
+            state->frameFiles.append(file);
+            if (!file->open(path, state->target.imageSize, settings.scratchCodec)) {
+                throw std::runtime_error("无法打开预处理后的临时文件。");
+            }
+        }
+
+        // 条带与临时文件的块对齐，续接点向下取整到块边界
+        const int height = state->target.imageSize.height();
+        int completedRows = journal.completedRows(t);
+        if (completedRows < height) completedRows -= completedRows % bandHeight;
+        if (isTiff) {
+            // TIFF先写到保存路径旁的.part文件，全部完成后再改名
+            const TiffStripWriter::ColorModel colorModel = isCmyk ? TiffStripWriter::ColorModel::Cmyk : TiffStripWriter::ColorModel::Rgb;
+            const QByteArray iccProfile = isCmyk ? settings.outputIccProfile : QColorSpace(QColorSpace::SRgb).iccProfile();
+            const QString partialPath = RenderJournal::partialOutputPath(state->target.savePath);
+            if (completedRows > 0 && state->tiffWriter.resume(partialPath, state->target.imageSize, colorModel,
+                                                              settings.outputDpi, iccProfile, completedRows)) {
+                state->completedRows = completedRows;
+            } else if (!state->tiffWriter.open(partialPath, state->target.imageSize, colorModel,
+                                               settings.outputDpi, iccProfile)) {
+                throw std::runtime_error(state->tiffWriter.errorString().toStdString());
+            }
+        } else if (isPdf) {
+            // PDF同样先写.part文件。页面尺寸由像素尺寸和输出DPI换算，即界面推荐的物理尺寸
+            const QByteArray iccProfile = isCmyk ? settings.outputIccProfile : QColorSpace(QColorSpace::SRgb).iccProfile();
+            const QString partialPath = RenderJournal::partialOutputPath(state->target.savePath);
+            if (completedRows > 0 && state->pdfWriter.resume(partialPath, state->target.imageSize, pdfColorModel,
+                                                             settings.outputDpi, iccProfile, completedRows)) {
+                state->completedRows = completedRows;
+            } else if (!state->pdfWriter.open(partialPath, state->target.imageSize, pdfColorModel,
+                                              settings.outputDpi, iccProfile)) {
+                throw std::runtime_error(state->pdfWriter.errorString().toStdString());
+            }
+        } else {
+            // 大页分配的结果图在这里不写入，各条带的物理内存由合成它的线程首次写入时分配
+            state->resultImage = settings.largePageBuffers
+                ? LargeBuffer::createImage(state->target.imageSize, QImage::Format_ARGB32)
+                : QImage(state->target.imageSize, QImage::Format_ARGB32);
+            if (state->resultImage.isNull()) throw std::bad_alloc();
+            // 写入物理分辨率，拼版时据此核对卡片与纸张的分辨率是否一致
+            if (settings.outputDpi > 0.0) {
+                const int dotsPerMeter = qRound(settings.outputDpi / 0.0254);
+                state->resultImage.setDotsPerMeterX(dotsPerMeter);
+                state->resultImage.setDotsPerMeterY(dotsPerMeter);
+            }
+            state->resultBits = state->resultImage.bits();
+            state->resultBytesPerLine = state->resultImage.bytesPerLine();
+            // PNG只在阶段一设检查点：再存一份未压缩的结果图会使输出的磁盘读写和占用翻倍，
+            // 续接时单线程读回也会破坏大页的首次写入分配。阶段二从缩放好的临时帧重新合成，代价很小
+        }
+
+        state->nextRow = state->completedRows;
+        totalRows += state->target.imageSize.height() - state->nextRow;
+        states.push_back(std::move(state));
+    }
+
+    // 每个目标同时在途的条带数。读盘在预读线程进行，合成与色彩转换在线程池中进行
+    const int maxInFlight = qMax(2, QThreadPool::globalInstance()->maxThreadCount() * 2);
+    const QString phaseTwoText = targetCount > 1
+        ? QString("正在处理2/2: 同时合成 %1 个尺寸的图像...").arg(targetCount)
+        : QString("正在处理2/2: 合成最终图像...");
+
+    // 条带写出并刷新到磁盘后才记入日志，日志中的行数永远不会超前于实际数据。PNG的结果图只在内存中，不记录行数
+    auto finishOldestBand = [&journal, isTiff, isPdf](TargetState& state) {
+        const CompositedBand band = state.pending.head().result();
+        state.pending.dequeue();
+        if (band.rows == 0) throw std::runtime_error("合成条带失败：内存不足或临时文件已损坏。");
+
+        if (isTiff) {
+            if (!state.tiffWriter.writeBand(band.strip) || !state.tiffWriter.flush()) {
+                throw std::runtime_error(state.tiffWriter.errorString().toStdString());
+            }
+        } else if (isPdf) {
+            if (!state.pdfWriter.writeEncodedBand(band.encoded, band.rows) || !state.pdfWriter.flush()) {
+                throw std::runtime_error(state.pdfWriter.errorString().toStdString());
+            }
+        }
+        state.completedRows += band.rows;
+        if (isTiff || isPdf) journal.markRows(state.index, state.completedRows);
+    };
+
+    // 各目标轮流提交一个条带，所有输出同时推进。先排出提交顺序，预读线程按同样的顺序读取
+    const bool useHalo = inBetween > 0 && interpolation == InterpolationMode::BlockMatching;
+    QList<TargetState*> bandOrder;
+    QList<BandPrefetcher::Request> readRequests;
+    std::vector<int> scheduledRows;
+    for (const auto& statePointer : states) scheduledRows.push_back(statePointer->nextRow);
+    for (bool hasRemainingRows = true; hasRemainingRows;) {
+        hasRemainingRows = false;
+        for (size_t i = 0; i < states.size(); ++i) {
+            const int height = states[i]->target.imageSize.height();
+            if (scheduledRows[i] >= height) continue;
+
+            // 一个条带恰好是临时文件中的一块，每帧一次读取；块匹配插帧时另读上下相邻的块
+            const int block = scheduledRows[i] / bandHeight;
+            const int firstBlock = useHalo ? qMax(0, block - 1) : block;
+            const int lastBlock = useHalo ? qMin(ScratchFrameFile::blockCount(height) - 1, block + 1) : block;
+            bandOrder.append(states[i].get());
+            readRequests.append(BandPrefetcher::Request{states[i]->frameFiles, firstBlock, lastBlock - firstBlock + 1});
+            scheduledRows[i] += bandHeight;
+            if (scheduledRows[i] < height) hasRemainingRows = true;
+        }
+    }
+
+    // 帧在内存中的目标不需要读盘，只为其他目标的条带预读
+    QList<BandPrefetcher::Request> fileRequests;
+    for (qsizetype b = 0; b < bandOrder.size(); ++b) {
+        if (bandOrder[b]->cachedFrames.isEmpty()) fileRequests.append(readRequests[b]);
+    }
+    int fileTargetCount = 0;
+    for (const auto& statePointer : states) {
+        if (statePointer->cachedFrames.isEmpty()) ++fileTargetCount;
+    }
+
+    // 预读器必须在各目标的临时文件之前销毁，因此声明在states之后。
+    // 每个读盘的目标最多有maxInFlight个条带在合成，环形缓冲区为它们留出槽，读取缓冲区得以复用
+    BandPrefetcher prefetcher(fileRequests, prefetchDepth, maxInFlight * fileTargetCount);
+    prefetcher.start();
+
+    qint64 rowsSubmitted = 0;
+    for (qsizetype b = 0; b < bandOrder.size(); ++b) {
+        if (!progress(50 + static_cast<int>(rowsSubmitted * 50 / qMax<qint64>(1, totalRows)), phaseTwoText)) return false;
+
+        TargetState& state = *bandOrder[b];
+        const int width = state.target.imageSize.width();
+        const int height = state.target.imageSize.height();
+        const int y = state.nextRow;
+        const int rows = qMin(bandHeight, height - y);
+        const int firstBlock = readRequests[b].firstBlock;
+        const int blockCount = readRequests[b].blockCount;
+
+        // 通常预读线程已经读完，这里不再等待磁盘；解码和插帧放到线程池中与合成一起进行
+        const QList<QImage> cachedFrames = state.cachedFrames;
+        const QList<QByteArray> storedBlocks = cachedFrames.isEmpty() ? prefetcher.take() : QList<QByteArray>();
+
+        uchar* resultBits = state.resultBits;
+        const qsizetype resultBytesPerLine = state.resultBytesPerLine;
+        state.pending.enqueue(QtConcurrent::run([=]() -> CompositedBand {
+            QImage strip = resultBits
+                ? QImage(resultBits + y * resultBytesPerLine, width, rows, resultBytesPerLine, QImage::Format_ARGB32)
+                : QImage(width, rows, QImage::Format_ARGB32);
+            if (strip.isNull()) return CompositedBand();
+
+            const QList<QByteArray> sourceBlocks = cachedFrames.isEmpty()
+                ? decodeBandSources(storedBlocks, scratchCodec, width, height,
+                                    firstBlock, blockCount, y, rows, frameOfSlot, inBetween, interpolation)
+                : bandSourcesFromImages(cachedFrames, width, height,
+                                        firstBlock, blockCount, y, rows, frameOfSlot, inBetween, interpolation);
+            if (sourceBlocks.isEmpty()) return CompositedBand();
+            generateLenticularStrip(strip, sourceBlocks, y, rows, isVertical, sliceWidth, crosstalk, isGrid ? &grid : nullptr);
+            if (isCmyk) {
+                strip.setColorSpace(QColorSpace::SRgb);
+                strip = strip.convertedToColorSpace(colorSpace, QImage::Format_CMYK8888);
+                if (strip.isNull()) return CompositedBand();
+            }
+            if (!isPdf) return CompositedBand{strip, QByteArray(), rows};
+
+            // PDF条带的压缩与合成一样在线程池中并行，写出线程只负责追加数据
+            const QByteArray encoded = PdfStripWriter::encodeBand(strip, pdfColorModel);
+            return encoded.isEmpty() ? CompositedBand() : CompositedBand{QImage(), encoded, rows};
+        }));
+
+        state.nextRow += rows;
+        rowsSubmitted += rows;
+
+        while (state.pending.size() >= maxInFlight) finishOldestBand(state);
+    }
+
+    for (const auto& statePointer : states) {
+        while (!statePointer->pending.isEmpty()) finishOldestBand(*statePointer);
+    }
+
+    // 保存最终结果。多个PNG同时编码
+    progress(100, phaseTwoText);
+    if (isTiff || isPdf) {
+        for (const auto& statePointer : states) {
+            const QString savePath = statePointer->target.savePath;
+            const QString partialPath = RenderJournal::partialOutputPath(savePath);
+            if (isTiff && !statePointer->tiffWriter.close()) {
+                throw std::runtime_error(statePointer->tiffWriter.errorString().toStdString());
+            }
+            if (isPdf && !statePointer->pdfWriter.close()) {
+                throw std::runtime_error(statePointer->pdfWriter.errorString().toStdString());
+            }
+            if (QFile::exists(savePath)) QFile::remove(savePath);
+            if (!QFile::rename(partialPath, savePath)) {
+                throw std::runtime_error(QString("保存最终文件失败！请检查路径或权限。\n%1").arg(savePath).toStdString());
+            }
+            journal.markSaved(statePointer->index);
+        }
+    } else {
+        QList<QFuture<bool>> saves;
+        for (const auto& statePointer : states) {
+            const QImage resultImage = statePointer->resultImage;
+            const QString savePath = statePointer->target.savePath;
+            saves.append(QtConcurrent::run([resultImage, savePath]() {
+                return resultImage.save(savePath, "PNG", 80);
+            }));
+        }
+        // 先等待全部保存结束，成功的目标记入日志，续接时只重新保存失败的目标
+        QStringList failedPaths;
+        for (size_t i = 0; i < states.size(); ++i) {
+            if (saves[int(i)].result()) {
+                journal.markSaved(states[i]->index);
+            } else {
+                failedPaths.append(states[i]->target.savePath);
+            }
+        }
+        if (!failedPaths.isEmpty()) {
+            throw std::runtime_error(QString("保存最终文件失败！请检查路径或权限。\n%1")
+                                         .arg(failedPaths.join("\n")).toStdString());
+        }
+    }
+    return true;
+}
+
+void LenticularRenderer::generateLenticularStrip(QImage& stripImage, const QList<QByteArray>& sourceBlocks, int y, int stripHeight, bool isVertical, int sliceWidth, double crosstalk,
+                                                 const InterleaveGrid* grid)
+{
+    if (sourceBlocks.isEmpty() || sliceWidth <= 0) return;
+    if (grid && grid->sliceHeight <= 0) return;
+
+    const int numFrames = sourceBlocks.size();
+    const int width = stripImage.width();
+    const int bytesPerPixel = 4; // ARGB32格式
+    const qsizetype sourceBytesPerLine = qsizetype(width) * bytesPerPixel;
+
+    // 串扰补偿：输出 = (本帧 - a*(前一帧 + 后一帧)) / (1 - 2a)，以16位定点数计算
+    const double fraction = qBound(0.0, crosstalk, maxCrosstalk);
+    const bool compensate = fraction > 0.0;
+    const int centerWeight = qRound(65536.0 / (1.0 - 2.0 * fraction));
+    const int neighborWeight = qRound(65536.0 * fraction / (1.0 - 2.0 * fraction));
+
+    // 复制或补偿一段连续的字节。帧在光栅下循环排列，第一帧与最后一帧相邻
+    auto frameData = [&](int frame, qsizetype offset) {
+        return reinterpret_cast<const uchar*>(sourceBlocks[frame].constData()) + offset;
+    };
+    auto emitSpan = [&](uchar* out, int frame, qsizetype offset, qsizetype count) {
+        if (!compensate) {
+            memcpy(out, frameData(frame, offset), count);
+            return;
+        }
+        compensateCrosstalk(out, frameData(frame, offset), frameData((frame + numFrames - 1) % numFrames, offset),
+                            frameData((frame + 1) % numFrames, offset), count, centerWeight, neighborWeight);
+    };
+
+    for (int row = 0; row < stripHeight; ++row) {
+        uchar* resultLine = stripImage.scanLine(row);
+        const qsizetype rowOffset = row * sourceBytesPerLine;
+
+        if (grid) {
+            // 一行中的帧只取决于所在的视点行；逐个视点列把该帧属于这一列的切片全部复制过去
+            const int sliceRow = (y + row) / grid->sliceHeight;
+            const int cellWidth = sliceWidth * grid->columns;
+            for (int column = 0; column < grid->columns && column * sliceWidth < width; ++column) {
+                const int frame = grid->frameAt(column, sliceRow, numFrames);
+                if (!compensate) {
+                    copyGridSlices(reinterpret_cast<quint32*>(resultLine), reinterpret_cast<const quint32*>(frameData(frame, rowOffset)),
+                                   width, column * sliceWidth, sliceWidth, cellWidth);
+                    continue;
+                }
+                // 串扰来自透镜下左右相邻的视点
+                const int previous = grid->frameAt(column + grid->columns - 1, sliceRow, numFrames);
+                const int next = grid->frameAt(column + 1, sliceRow, numFrames);
+                for (int x = column * sliceWidth; x < width; x += cellWidth) {
+                    const qsizetype offset = rowOffset + qsizetype(x) * bytesPerPixel;
+                    compensateCrosstalk(resultLine + qsizetype(x) * bytesPerPixel, frameData(frame, offset), frameData(previous, offset),
+                                        frameData(next, offset), qsizetype(qMin(sliceWidth, width - x)) * bytesPerPixel,
+                                        centerWeight, neighborWeight);
+                }
+            }
+        } else if (isVertical) {
+            // 以整个切片为单位复制，而不是逐像素复制
+            for (int x = 0; x < width; x += sliceWidth) {
+                int sourceImageIndex = (x / sliceWidth) % numFrames;
+                int span = qMin(sliceWidth, width - x);
+                emitSpan(resultLine + (x * bytesPerPixel), sourceImageIndex,
+                         rowOffset + (x * bytesPerPixel), span * bytesPerPixel);
+            }
+        } else { // 横向切分
+            int sourceImageIndex = ((y + row) / sliceWidth) % numFrames;
+            // 将一整行裸数据直接复制过去
+            emitSpan(resultLine, sourceImageIndex, rowOffset, sourceBytesPerLine);
+        }
+    }
+}
@@ -0,0 +1,146 @@
+#ifndef LENTICULARRENDERER_H
+#define LENTICULARRENDERER_H
+
+#include "scratchframe.h"
+#include "frameinterpolation.h"
+#include "frametransform.h"
+#include "interleavegrid.h"
+
+#include <QList>
+#include <QString>
+#include <QSize>
+#include <QImage>
+#include <QByteArray>
+#include <QColorSpace>
+#include <QJsonObject>
+#include <functional>
+
+class RenderJournal;
+class FrameCache;
+
+/// @brief 最终输出文件的格式。
+enum class OutputFormat {
+    Png,        ///< RGB PNG，整图在内存中合成后一次性保存
+    CmykTiff,   ///< CMYK TIFF，按条带转换色彩空间并流式写出，不持有整图
+    RgbTiff,    ///< RGB TIFF，按条带流式写出，不持有整图
+    CmykPdf,    ///< CMYK PDF，页面为打印的物理尺寸，按条带压缩并流式写出
+    RgbPdf      ///< RGB PDF，页面为打印的物理尺寸，按条带压缩并流式写出
+};
+
+/**
+ * @struct RenderTarget
+ * @brief 一个输出文件：像素尺寸及保存路径。
+ */
+struct RenderTarget {
+    QSize imageSize;    ///< 输出图像的像素尺寸
+    QString savePath;   ///< 输出文件路径
+};
+
+/**
+ * @struct RenderSettings
+ * @brief 一次最终渲染所需的全部参数快照，与界面控件解耦。
+ */
+struct RenderSettings {
+    QList<QString> imagePaths;      ///< 按帧顺序排列的源图像路径
+    QList<int> frameHolds;          ///< 与imagePaths对应，每帧在光栅单元中占用的切片位置数；为空或缺项时为1
+    QList<FrameTransform> frameTransforms; ///< 与imagePaths对应，每帧的画面调整；为空或缺项时不调整
+    QList<RenderTarget> targets;    ///< 输出目标。多个目标共享同一次解码，并同时合成
+    bool isVertical = true;         ///< 是否为纵向切分
+    int sliceWidth = 4;             ///< 每个切片的像素宽度
+    bool isGrid = false;            ///< 是否二维交错(蝇眼/微透镜阵列)，为true时忽略isVertical
+    int gridColumns = 0;            ///< 二维交错时水平方向的视点数，0为自动(见InterleaveGrid::resolve)
+    int sliceHeight = 0;            ///< 二维交错时每个切片的像素高度，0为自动
+    double outputDpi = 0.0;         ///< 写入输出文件的物理分辨率(DPI)
+    OutputFormat outputFormat = OutputFormat::Png;
+    QByteArray outputIccProfile;    ///< CMYK输出使用的ICC配置文件内容
+    ScratchCodec scratchCodec = ScratchCodec::Deflate; ///< 阶段一临时帧文件的编码方式
+    bool alignFrames = false;       ///< 是否自动对齐各帧(用于手持拍摄的帧序列)
+    double crosstalk = 0.0;         ///< 串扰补偿比例：从每个切片中减去相邻两帧各多少比例的内容，0为不补偿
+    int inBetweenFrames = 0;        ///< 每两张相邻的导入帧之间合成的中间帧数
+    InterpolationMode interpolation = InterpolationMode::CrossFade; ///< 中间帧的合成方式
+    double sharpenAmount = 0.0;     ///< 缩放后USM锐化的强度，0为不锐化，1为100%
+    double sharpenRadius = 1.0;     ///< USM锐化的半径(输出图像的像素)
+    bool linearLightScaling = false; ///< 阶段一是否在线性光空间中缩放(见LinearLightScaler)，否则与较早版本一样直接在sRGB中缩放
+    bool largePageBuffers = false;  ///< 结果图使用大页内存，并由合成各条带的线程首次写入(NUMA本地)
+};
+
+/// @brief 将渲染参数转换为JSON，用于保存任务信息。
+QJsonObject renderSettingsToJson(const RenderSettings& settings);
+
+/// @brief 从JSON读取渲染参数；缺失的字段取默认值。
+RenderSettings renderSettingsFromJson(const QJsonObject& json);
+
+/**
+ * @brief 按停留次数展开帧序列：返回每个切片位置对应的导入帧下标。
+ * @param frameHolds 每帧的停留次数，为空或缺项时为1，小于1时按1计。
+ */
+QList<int> frameSlotSequence(const QList<int>& frameHolds, int frameCount);
+
+/**
+ * @class LenticularRenderer
+ * @brief 最终光栅图像的两阶段渲染器。
+ *
+ * 阶段一将每帧解码一次，缩放到各目标尺寸后写入临时文件；阶段二按条带从临时文件读取各帧的对应行，
+ * 在线程池中并行合成(以及色彩转换)，再按顺序写出。多个目标的条带交替提交，同时推进。
+ * 临时文件存放在任务的持久工作目录中，两个阶段的进度都记入RenderJournal，中断后再次运行相同的任务会从检查点继续。
+ */
+class LenticularRenderer
+{
+public:
+    /// @brief 进度回调。percent为0~100的总进度，stage为当前阶段描述；返回false表示取消。
+    using ProgressCallback = std::function<bool(int percent, const QString& stage)>;
+
+    explicit LenticularRenderer(const RenderSettings& settings);
+
+    /**
+     * @brief 执行完整的渲染流程并写出所有目标文件。
+     * @return 正常完成返回true，被取消返回false。出错时抛出std::exception。
+     * 取消或出错时已完成的进度会保留，再次运行相同的任务时从检查点继续。
+     */
+    bool run(const ProgressCallback& progress);
+
+    /**
+     * @brief 设置阶段一使用的帧缓存，命中时跳过解码和缩放。默认不使用缓存。
+     */
+    void setFrameCache(FrameCache* cache) { frameCache = cache; }
+
+    /**
+     * @brief 【核心算法】用各帧的行数据块填充目标条带。
+     * @param stripImage 目标条带图像，其第0行对应输出图像的第y行。
+     * @param sourceBlocks 每帧一个数据块，各含stripHeight行紧密排列的ARGB32像素。
+     * @param y 条带第一行在输出图像中的Y坐标。
+     * @param stripHeight 条带的行数。
+     * @param isVertical 是否为纵向切分。
+     * @param sliceWidth 每个切片的像素宽度。
+     * @param crosstalk 串扰补偿比例(0~maxCrosstalk)，在同一次遍历中从每个切片减去相邻帧的对应内容。
+     * @param grid 二维交错的视点矩阵，为空时按isVertical一维交错。二维交错时串扰补偿取同一视点行中左右相邻的视点。
+     */
+    static void generateLenticularStrip(QImage& stripImage, const QList<QByteArray>& sourceBlocks, int y, int stripHeight, bool isVertical, int sliceWidth, double crosstalk,
+                                        const InterleaveGrid* grid = nullptr);
+
+    /// @brief 串扰补偿比例的上限。
+    static constexpr double maxCrosstalk = 0.25;
+
+private:
+    RenderSettings settings;
+    QColorSpace printColorSpace;    ///< CMYK输出的目标色彩空间
+    FrameCache* frameCache = nullptr;
+    QList<int> uniqueSources;       ///< 内容互不相同的帧，各取第一次出现的导入帧下标
+    QList<int> slotSources;         ///< 每个切片位置(不含中间帧)使用uniqueSources中的哪一帧
+    QList<QList<QImage>> cachedTargetFrames; ///< 全部帧都来自缓存的目标在阶段二直接读取的缩放帧；其他目标为空
+
+    /**
+     * @brief 阶段一：找出内容相同的帧，每个不同的帧解码一次，缩放到每个目标尺寸并写入工作目录。
+     * 检查点中已完成的帧跳过。一个目标的全部帧都命中缓存时不写临时文件，记入cachedTargetFrames。
+     * @return 每个目标一组临时文件路径(按uniqueSources的顺序)；被取消时返回空列表。
+     */
+    QList<QList<QString>> preprocessFrames(RenderJournal& journal, const ProgressCallback& progress);
+
+    /**
+     * @brief 阶段二：同时合成所有目标并写出文件，从各目标检查点记录的行继续。
+     * @return 正常完成返回true，被取消返回false。
+     */
+    bool compositeTargets(RenderJournal& journal, const QList<QList<QString>>& scaledFramePaths, const ProgressCallback& progress);
+};
+
+#endif // LENTICULARRENDERER_H
@@ -0,0 +1,229 @@
+#include "linearscaler.h"
+
+#include <QList>
+#include <QtConcurrent/QtConcurrentMap>
+#include <algorithm>
+#include <vector>
+#include <cmath>
+
+namespace {
+
+constexpr int channels = 4; // 线性光缓冲区中每像素的分量：R、G、B、A
+
+/// @brief 每个并行任务合成的输出行数。块越大，块边界处重复水平缩放的源行越少，但每个任务的累加缓冲区(块高×目标宽度)也越大
+constexpr int blockRows = 16;
+
+/// @brief 线性光到sRGB查找表的精度(14位)，暗部相邻的两级sRGB值仍能区分
+constexpr int fromLinearBits = 14;
+constexpr int fromLinearMax = (1 << fromLinearBits) - 1;
+
+/**
+ * @brief sRGB与线性光之间的查找表，首次使用时生成。
+ */
+struct GammaTables {
+    float toLinear[256];
+    uchar fromLinear[fromLinearMax + 1];
+
+    GammaTables()
+    {
+        for (int i = 0; i < 256; ++i) {
+            const double v = i / 255.0;
+            toLinear[i] = static_cast<float>(v <= 0.04045 ? v / 12.92 : std::pow((v + 0.055) / 1.055, 2.4));
+        }
+        for (int i = 0; i <= fromLinearMax; ++i) {
+            const double v = double(i) / fromLinearMax;
+            const double encoded = v <= 0.0031308 ? v * 12.92 : 1.055 * std::pow(v, 1.0 / 2.4) - 0.055;
+            fromLinear[i] = static_cast<uchar>(qBound(0L, std::lround(encoded * 255.0), 255L));
+        }
+    }
+};
+
+const GammaTables& gammaTables()
+{
+    static const GammaTables tables;
+    return tables;
+}
+
+/**
+ * @brief 一个方向上的重采样抽头：每个输出像素固定count个源像素下标和权重，不足的以权重0补齐，卷积中没有分支。
+ */
+struct FilterTaps {
+    int count = 0;
+    std::vector<int> index;     ///< 源像素下标，已限制在源图像范围内
+    std::vector<float> weight;  ///< 归一化的权重
+};
+
+/**
+ * @brief 计算三角滤波器的抽头。缩小时滤波器半径等于缩小倍数，放大时为1(即双线性插值)。
+ * @param start 源区域起点(像素，可为小数)。
+ * @param length 源区域长度(像素)。
+ */
+FilterTaps computeTaps(double start, double length, int sourceSize, int targetSize)
+{
+    const double step = length / targetSize;
+    const double support = qMax(1.0, step);
+
+    FilterTaps taps;
+    taps.count = static_cast<int>(std::ceil(support * 2.0)) + 1;
+    taps.index.resize(size_t(targetSize) * taps.count);
+    taps.weight.resize(size_t(targetSize) * taps.count);
+    for (int i = 0; i < targetSize; ++i) {
+        const double center = start + (i + 0.5) * step;
+        const int first = static_cast<int>(std::floor(center - support - 0.5)) + 1;
+        int* index = taps.index.data() + size_t(i) * taps.count;
+        float* weight = taps.weight.data() + size_t(i) * taps.count;
+        double sum = 0.0;
+        for (int k = 0; k < taps.count; ++k) {
+            const double w = qMax(0.0, 1.0 - std::abs(first + k + 0.5 - center) / support);
+            index[k] = qBound(0, first + k, sourceSize - 1);
+            weight[k] = static_cast<float>(w);
+            sum += w;
+        }
+        for (int k = 0; k < taps.count; ++k) weight[k] = static_cast<float>(weight[k] / sum);
+    }
+    return taps;
+}
+
+/**
+ * @brief 将一行源像素的[firstColumn, firstColumn + columnCount)列转换为预乘透明度的线性光浮点数。
+ * @param alphaMask RGB32源图像为0xff000000，其透明度字节未定义，按不透明读取。
+ */
+void linearizeRow(const QRgb* line, int firstColumn, int columnCount, QRgb alphaMask, float* __restrict out)
+{
+    const float* toLinear = gammaTables().toLinear;
+    for (int x = 0; x < columnCount; ++x) {
+        const QRgb pixel = line[firstColumn + x] | alphaMask;
+        const float alpha = qAlpha(pixel) * (1.0f / 255.0f);
+        out[x * channels + 0] = toLinear[qRed(pixel)] * alpha;
+        out[x * channels + 1] = toLinear[qGreen(pixel)] * alpha;
+        out[x * channels + 2] = toLinear[qBlue(pixel)] * alpha;
+        out[x * channels + 3] = alpha;
+    }
+}
+
+/**
+ * @brief 水平重采样一行。每个输出像素的四个分量一起乘加，正好是一个4路浮点向量。
+ * @param source 从水平抽头的最小下标开始的线性光行。
+ */
+void filterRowHorizontally(const float* __restrict source, const FilterTaps& taps, int indexOffset,
+                           int targetWidth, float* __restrict out)
+{
+    for (int x = 0; x < targetWidth; ++x) {
+        const int* index = taps.index.data() + size_t(x) * taps.count;
+        const float* weight = taps.weight.data() + size_t(x) * taps.count;
+        float sum[channels] = {0.0f, 0.0f, 0.0f, 0.0f};
+        for (int k = 0; k < taps.count; ++k) {
+            const float* pixel = source + size_t(index[k] - indexOffset) * channels;
+            for (int c = 0; c < channels; ++c) sum[c] += weight[k] * pixel[c];
+        }
+        for (int c = 0; c < channels; ++c) out[size_t(x) * channels + c] = sum[c];
+    }
+}
+
+/**
+ * @brief 将一行线性光结果转换回sRGB的ARGB32像素，去除预乘。
+ */
+void encodeRow(const float* __restrict linear, int width, QRgb* out)
+{
+    const uchar* fromLinear = gammaTables().fromLinear;
+    auto encode = [fromLinear](float value) {
+        return fromLinear[static_cast<int>(qBound(0.0f, value, 1.0f) * fromLinearMax + 0.5f)];
+    };
+    for (int x = 0; x < width; ++x) {
+        const float* pixel = linear + size_t(x) * channels;
+        const float alpha = pixel[3];
+        const float inverse = alpha > 0.0f ? 1.0f / alpha : 0.0f;
+        out[x] = qRgba(encode(pixel[0] * inverse), encode(pixel[1] * inverse), encode(pixel[2] * inverse),
+                       qBound(0, static_cast<int>(alpha * 255.0f + 0.5f), 255));
+    }
+}
+
+/**
+ * @brief 合成一个输出行块：逐行水平缩放块内用到的源行，立即按垂直权重累加到块内各输出行，最后转换回sRGB。
+ * 不保留水平缩放后的源行，缓冲区只与块高和目标宽度有关，大比例缩小时也不会随缩小倍数增长。
+ */
+void scaleRows(const QImage& source, const FilterTaps& horizontalTaps, const FilterTaps& verticalTaps,
+               int targetWidth, uchar* resultBits, qsizetype resultBytesPerLine, int firstRow, int rowCount)
+{
+    const auto firstIndex = verticalTaps.index.begin() + size_t(firstRow) * verticalTaps.count;
+    const auto lastIndex = firstIndex + size_t(rowCount) * verticalTaps.count;
+    const int firstSourceRow = *std::min_element(firstIndex, lastIndex);
+    const int lastSourceRow = *std::max_element(firstIndex, lastIndex);
+
+    const int firstColumn = *std::min_element(horizontalTaps.index.begin(), horizontalTaps.index.end());
+    const int columnCount = *std::max_element(horizontalTaps.index.begin(), horizontalTaps.index.end()) - firstColumn + 1;
+    const size_t lineFloats = size_t(targetWidth) * channels;
+    const QRgb alphaMask = source.format() == QImage::Format_RGB32 ? 0xff000000u : 0u;
+
+    std::vector<float> linearRow(size_t(columnCount) * channels);
+    std::vector<float> horizontal(lineFloats);
+    std::vector<float> accumulators(size_t(rowCount) * lineFloats, 0.0f);
+    std::vector<float> rowWeights(rowCount);
+    for (int sourceRow = firstSourceRow; sourceRow <= lastSourceRow; ++sourceRow) {
+        // 这一源行对块内每个输出行的权重；边缘处被限制到同一源行的抽头合并计算
+        bool used = false;
+        for (int r = 0; r < rowCount; ++r) {
+            const size_t tap = size_t(firstRow + r) * verticalTaps.count;
+            float weight = 0.0f;
+            for (int k = 0; k < verticalTaps.count; ++k) {
+                if (verticalTaps.index[tap + k] == sourceRow) weight += verticalTaps.weight[tap + k];
+            }
+            rowWeights[r] = weight;
+            used = used || weight != 0.0f;
+        }
+        if (!used) continue;
+
+        const QRgb* line = reinterpret_cast<const QRgb*>(source.constScanLine(sourceRow));
+        linearizeRow(line, firstColumn, columnCount, alphaMask, linearRow.data());
+        filterRowHorizontally(linearRow.data(), horizontalTaps, firstColumn, targetWidth, horizontal.data());
+
+        const float* __restrict row = horizontal.data();
+        for (int r = 0; r < rowCount; ++r) {
+            const float weight = rowWeights[r];
+            if (weight == 0.0f) continue;
+            float* __restrict sum = accumulators.data() + size_t(r) * lineFloats;
+            // 按像素的四个分量成组乘加，与水平卷积一样在-O2下即可编译为4路浮点向量
+            for (size_t i = 0; i < lineFloats; i += channels) {
+                for (int c = 0; c < channels; ++c) sum[i + c] += weight * row[i + c];
+            }
+        }
+    }
+
+    for (int r = 0; r < rowCount; ++r) {
+        encodeRow(accumulators.data() + size_t(r) * lineFloats, targetWidth,
+                  reinterpret_cast<QRgb*>(resultBits + (firstRow + r) * resultBytesPerLine));
+    }
+}
+
+} // namespace
+
+QImage LinearLightScaler::scale(const QImage& image, const QSize& targetSize)
+{
+    return scale(image, QRectF(QPointF(0, 0), QSizeF(image.size())), targetSize);
+}
+
+QImage LinearLightScaler::scale(const QImage& image, const QRectF& sourceRect, const QSize& targetSize)
+{
+    if (image.isNull() || targetSize.isEmpty() || sourceRect.isEmpty()) return QImage();
+
+    // ARGB32和RGB32直接读取，其余格式才转换，常见的不透明照片不必整幅复制
+    const bool direct = image.format() == QImage::Format_ARGB32 || image.format() == QImage::Format_RGB32;
+    const QImage source = direct ? image : image.convertToFormat(QImage::Format_ARGB32);
+    QImage result(targetSize, QImage::Format_ARGB32);
+    if (source.isNull() || result.isNull()) return QImage();
+
+    const FilterTaps horizontalTaps = computeTaps(sourceRect.x(), sourceRect.width(), source.width(), targetSize.width());
+    const FilterTaps verticalTaps = computeTaps(sourceRect.y(), sourceRect.height(), source.height(), targetSize.height());
+
+    uchar* resultBits = result.bits();
+    const qsizetype resultBytesPerLine = result.bytesPerLine();
+
+    // 按blockRows(16行)分块并行，与临时文件的64行块无关：块高决定每个任务累加缓冲区的大小
+    QList<int> firstRows;
+    for (int y = 0; y < targetSize.height(); y += blockRows) firstRows.append(y);
+    QtConcurrent::blockingMap(firstRows, [&](int firstRow) {
+        scaleRows(source, horizontalTaps, verticalTaps, targetSize.width(), resultBits, resultBytesPerLine,
+                  firstRow, qMin(blockRows, targetSize.height() - firstRow));
+    });
+    return result;
+}
@@ -0,0 +1,34 @@
+#ifndef LINEARSCALER_H
+#define LINEARSCALER_H
+
+#include <QImage>
+#include <QRectF>
+#include <QSize>
+
+/**
+ * @class LinearLightScaler
+ * @brief 在线性光空间中缩放图像，大比例缩小时细节不会变暗，颜色不会偏移。
+ *
+ * sRGB值经查找表转换为线性光的浮点数(预乘透明度)，用三角滤波器分别在水平和垂直方向重采样，再经查找表转换回sRGB。
+ * 缩小时滤波器按缩小倍数展宽，覆盖所有源像素，不需要先建金字塔。
+ * 按行块在线程池中并行计算；每块逐行水平缩放所需的源行并立即累加到块内各输出行，每个任务的缓冲区与缩小倍数无关。
+ * 卷积都是连续浮点数上的乘加，编译器可以自动向量化。ARGB32和RGB32图像直接读取，不做格式转换。
+ */
+class LinearLightScaler
+{
+public:
+    /**
+     * @brief 将整幅图像缩放到目标尺寸。
+     * @return ARGB32格式的图像；内存不足时返回空图像。
+     */
+    static QImage scale(const QImage& image, const QSize& targetSize);
+
+    /**
+     * @brief 将源图像中的一个区域缩放到目标尺寸，区域可以是小数坐标(用于对齐后的取景)。
+     * 超出源图像的部分取边缘像素。
+     * @return ARGB32格式的图像；内存不足时返回空图像。
+     */
+    static QImage scale(const QImage& image, const QRectF& sourceRect, const QSize& targetSize);
+};
+
+#endif // LINEARSCALER_H
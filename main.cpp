@@ -1,4 +1,5 @@
 #include "mainwindow.h"
+#include "renderserver.h"
 
 #include <QApplication>
 #include <QLocale>
@@ -7,6 +8,11 @@
 
 int main(int argc, char *argv[])
 {
+    // 以 --server 启动时不创建界面，作为常驻渲染服务运行
+    for (int i = 1; i < argc; ++i) {
+        if (qstrcmp(argv[i], "--server") == 0) return RenderServer::exec(argc, argv);
+    }
+
     QApplication a(argc, argv);
 
     QTranslator translator;
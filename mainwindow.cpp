@@ -1,4 +1,11 @@
 #include "mainwindow.h"
+#include "lenticularrenderer.h"
+#include "calibrationsheet.h"
+#include "imposition.h"
+#include "renderjournal.h"
+#include "renderqueue.h"
+#include "renderqueuepanel.h"
+#include "framesharpener.h"
 
 #include <QApplication>
 #include <QLabel>
@@ -21,13 +28,34 @@
 #include <QDoubleSpinBox>
 #include <QTextBrowser>
 #include <algorithm>
+#include <stdexcept>
 #include <QDesktopServices>
 #include <QUrl>
 #include <QTemporaryDir>
 #include <QImageWriter>
 #include <QImageReader>
 #include <QScopedPointer>
-
+#include <QMenu>
+#include <QDialogButtonBox>
+#include <QInputDialog>
+#include <QLineEdit>
+#include <QRegularExpression>
+#include <QCheckBox>
+#include <QCloseEvent>
+#include <QComboBox>
+#include <QHash>
+
+namespace {
+// 保存对话框中的输出格式过滤器
+const char* const pngFilter = "PNG图像 (*.png)";
+const char* const cmykTiffFilter = "CMYK TIFF印刷图像 (*.tif *.tiff)";
+const char* const rgbTiffFilter = "RGB TIFF图像 (*.tif *.tiff)";
+const char* const cmykPdfFilter = "CMYK PDF印刷文件 (*.pdf)";
+const char* const rgbPdfFilter = "RGB PDF文件 (*.pdf)";
+
+// 渲染中断后的续接提示
+const char* const resumeHint = "已完成的进度已保存，再次生成相同的图像或重新启动程序时可从中断处继续。";
+}
 
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent)
@@ -42,11 +70,36 @@ MainWindow::MainWindow(QWidget *parent)
     setupStyles();
     setupConnections();
     updateButtonStates();
+
+    // 窗口显示后检查上次未完成的渲染任务
+    QTimer::singleShot(0, this, &MainWindow::resumeInterruptedRenders);
 }
 
 MainWindow::~MainWindow()
 {}
 
+void MainWindow::closeEvent(QCloseEvent* event)
+{
+    if (renderQueue->isBusy()) {
+        const int choice = QMessageBox::question(this, "退出确认",
+                                                 "仍有渲染任务正在进行或排队。\n\n"
+                                                 "退出将中断这些任务：正在渲染的任务会保留已完成的进度，下次启动时可以继续；排队中的任务不会保留。\n\n"
+                                                 "确定要退出吗？",
+                                                 "退出", "取消");
+        if (choice == 1) {
+            event->ignore();
+            return;
+        }
+
+        // 渲染器在下一个条带处停止，等待它写完检查点
+        renderQueue->cancelAll();
+        QApplication::setOverrideCursor(Qt::WaitCursor);
+        renderQueue->waitForCurrentJob();
+        QApplication::restoreOverrideCursor();
+    }
+    event->accept();
+}
+
 void MainWindow::setupUI()
 {
     // --- 中央控件 ---
@@ -72,18 +125,32 @@ void MainWindow::setupUI()
     const int controlWidth = rightPanelWidth - labelWidth - 25; // 输入控件的统一宽度
 
     // --- 控制面板: 图像管理 ---
-    const int importButtonWidth = rightPanelWidth - 45;
+    const int importButtonWidth = rightPanelWidth - 85;
     importButton = new QPushButton("导入图像...", centralWidget);
     importButton->setGeometry(rightPanelX, 10, importButtonWidth, 35);
 
+    toolsButton = new QPushButton(centralWidget);
+    toolsButton->setGeometry(rightPanelX + importButtonWidth + 5, 10, 35, 35);
+    toolsButton->setToolTip("更多工具");
+    toolsMenu = new QMenu(toolsButton);
+    multiSizeAction = toolsMenu->addAction("多尺寸批量输出...");
+    calibrationSheetAction = toolsMenu->addAction("生成LPI校准测试页...");
+    impositionAction = toolsMenu->addAction("N拼版到印刷纸...");
+    toolsMenu->addSeparator();
+    renderOptionsAction = toolsMenu->addAction("渲染选项...");
+    gridSettingsAction = toolsMenu->addAction("二维交错设置...");
+    renderQueueAction = toolsMenu->addAction("渲染任务...");
+    toolsButton->setMenu(toolsMenu);
+
     helpButton = new QPushButton(centralWidget);
-    helpButton->setGeometry(rightPanelX + importButtonWidth + 5, 10, 35, 35);
+    helpButton->setGeometry(rightPanelX + importButtonWidth + 45, 10, 35, 35);
     helpButton->setToolTip("查看操作指南");
 
     imageListWidget = new QListWidget(centralWidget);
     imageListWidget->setGeometry(rightPanelX, 55, rightPanelWidth, 250);
     imageListWidget->setIconSize(QSize(64, 64));
     imageListWidget->setSelectionMode(QAbstractItemView::ExtendedSelection);
+    imageListWidget->setContextMenuPolicy(Qt::CustomContextMenu);
 
     moveUpButton = new QPushButton("上移", centralWidget);
     moveUpButton->setGeometry(rightPanelX, 315, (rightPanelWidth / 3) - 4, 30);
@@ -101,9 +168,13 @@ void MainWindow::setupUI()
     QLabel* directionLabel = new QLabel("切分方向:", settingsGroup);
     directionLabel->setGeometry(15, 30, labelWidth, 25);
     verticalRadio = new QRadioButton("纵向", settingsGroup);
-    verticalRadio->setGeometry(labelWidth + 15, 30, 80, 25);
+    verticalRadio->setGeometry(labelWidth + 15, 30, 60, 25);
     horizontalRadio = new QRadioButton("横向", settingsGroup);
-    horizontalRadio->setGeometry(labelWidth + 95, 30, 80, 25);
+    horizontalRadio->setGeometry(labelWidth + 75, 30, 60, 25);
+    gridRadio = new QRadioButton("二维", settingsGroup);
+    gridRadio->setGeometry(labelWidth + 135, 30, 60, 25);
+    gridRadio->setToolTip("蝇眼/微透镜阵列：每个透镜单元下按行列排列多个视点，上下左右晃动都能看到变化。\n"
+                          "视点矩阵和切片高度在“更多工具 → 二维交错设置”中调整。");
     verticalRadio->setChecked(true);
 
     QLabel* sliceWidthLabel = new QLabel("切片宽度(像素):", settingsGroup);
@@ -157,6 +228,10 @@ void MainWindow::setupUI()
     saveButton = new QPushButton(" 生成并保存图像...", centralWidget);
     saveButton->setObjectName("saveButton");
     saveButton->setGeometry(rightPanelX, 630, rightPanelWidth, 40);
+
+    // --- 后台渲染队列及其任务面板(独立的非模态窗口) ---
+    renderQueue = new RenderQueue(this);
+    renderQueuePanel = new RenderQueuePanel(renderQueue, this);
 }
 
 void MainWindow::setupStyles()
@@ -173,6 +248,7 @@ void MainWindow::setupStyles()
     // 为按钮设置图标、字体
     importButton->setIcon(this->style()->standardIcon(QStyle::SP_DirOpenIcon));
     helpButton->setIcon(this->style()->standardIcon(QStyle::SP_DialogHelpButton));
+    toolsButton->setIcon(this->style()->standardIcon(QStyle::SP_FileDialogDetailedView));
     deleteButton->setIcon(this->style()->standardIcon(QStyle::SP_TrashIcon));
     moveUpButton->setIcon(this->style()->standardIcon(QStyle::SP_ArrowUp));
     moveDownButton->setIcon(this->style()->standardIcon(QStyle::SP_ArrowDown));
@@ -188,6 +264,7 @@ void MainWindow::setupStyles()
     moveDownButton->setIconSize(secondaryIconSize);
     deleteButton->setIconSize(secondaryIconSize);
     helpButton->setIconSize(secondaryIconSize);
+    toolsButton->setIconSize(secondaryIconSize);
 
     resetPrintSizeButton->setFont(QFont("宋体", 14));
 }
@@ -197,22 +274,33 @@ void MainWindow::setupConnections()
     // 连接UI控件的信号到槽函数
     connect(importButton, &QPushButton::clicked, this, &MainWindow::importImages);
     connect(helpButton, &QPushButton::clicked, this, &MainWindow::showHelpDialog);
+    connect(multiSizeAction, &QAction::triggered, this, &MainWindow::saveMultipleSizes);
+    connect(calibrationSheetAction, &QAction::triggered, this, &MainWindow::generateCalibrationSheet);
+    connect(impositionAction, &QAction::triggered, this, &MainWindow::imposeCardsOnSheet);
+    connect(renderOptionsAction, &QAction::triggered, this, &MainWindow::editRenderOptions);
+    connect(gridSettingsAction, &QAction::triggered, this, &MainWindow::editGridSettings);
+    connect(renderQueueAction, &QAction::triggered, this, &MainWindow::showRenderQueuePanel);
+    connect(renderQueue, &RenderQueue::jobFinished, this, &MainWindow::onRenderJobFinished);
     connect(deleteButton, &QPushButton::clicked, this, &MainWindow::deleteSelectedImage);
     connect(moveUpButton, &QPushButton::clicked, this, &MainWindow::moveImageUp);
     connect(moveDownButton, &QPushButton::clicked, this, &MainWindow::moveImageDown);
     connect(saveButton, &QPushButton::clicked, this, &MainWindow::saveFinalImage);
     connect(imageListWidget, &QListWidget::itemSelectionChanged, this, &MainWindow::updateButtonStates);
+    connect(imageListWidget, &QListWidget::itemDoubleClicked, this, &MainWindow::editFrameHold);
+    connect(imageListWidget, &QListWidget::customContextMenuRequested, this, &MainWindow::showImageListMenu);
     connect(resetPrintSizeButton, &QPushButton::clicked, this, &MainWindow::onResetPrintSizeClicked);
 
     // 当合成参数变化时，调度预览更新
     connect(verticalRadio, &QRadioButton::toggled, this, &MainWindow::schedulePreviewUpdate);
     connect(horizontalRadio, &QRadioButton::toggled, this, &MainWindow::schedulePreviewUpdate);
+    connect(gridRadio, &QRadioButton::toggled, this, &MainWindow::schedulePreviewUpdate);
     connect(sliceWidthSpinBox, QOverload<int>::of(&QSpinBox::valueChanged), this, &MainWindow::schedulePreviewUpdate);
 
 
     // 将所有核心参数的变化连接到新的重置槽函数
     connect(verticalRadio, &QRadioButton::toggled, this, &MainWindow::onCoreParametersChanged);
     connect(horizontalRadio, &QRadioButton::toggled, this, &MainWindow::onCoreParametersChanged);
+    connect(gridRadio, &QRadioButton::toggled, this, &MainWindow::onCoreParametersChanged);
     connect(sliceWidthSpinBox, QOverload<int>::of(&QSpinBox::valueChanged), this, &MainWindow::onCoreParametersChanged);
     connect(actualLpiSpinBox, QOverload<double>::of(&QDoubleSpinBox::valueChanged), this, &MainWindow::onCoreParametersChanged);
     connect(calibratedLpiSpinBox, QOverload<double>::of(&QDoubleSpinBox::valueChanged), this, &MainWindow::onCoreParametersChanged);
@@ -238,10 +326,14 @@ void MainWindow::importImages()
 
         if (choice == 1) { // 如果清空
             imagePaths.clear();
+            frameHolds.clear();
+            frameTransforms.clear();
         }
     }
 
     imagePaths.append(files);
+    frameHolds.append(QList<int>(files.size(), 1));
+    frameTransforms.append(QList<FrameTransform>(files.size()));
     updateImageList(); // 先更新列表，以便后续计算获取正确的帧数
 
     // 导入后，重置为自动模式
@@ -297,6 +389,608 @@ void MainWindow::showHelpDialog()
     helpDialog->exec();
 }
 
+void MainWindow::saveMultipleSizes()
+{
+    if (imagePaths.isEmpty()) {
+        QMessageBox::warning(this, "警告", "请先导入至少一张图像！");
+        return;
+    }
+
+    const QSize firstImageSize = firstFrameSize();
+    if (firstImageSize.isEmpty()) {
+        QMessageBox::critical(this, "错误", "无法加载第一张图像以获取尺寸信息。");
+        return;
+    }
+
+    // 输入多个打印宽度
+    bool ok = false;
+    QString input = QInputDialog::getText(this, "多尺寸批量输出",
+                                          "请输入多个打印宽度(厘米)，以逗号分隔：\n例如: 5, 7.5, 10",
+                                          QLineEdit::Normal, "", &ok);
+    if (!ok || input.trimmed().isEmpty()) return;
+
+    QList<double> widthsCm;
+    const QStringList parts = input.split(QRegularExpression("[,，;；\\s]+"), Qt::SkipEmptyParts);
+    for (const QString& part : parts) {
+        bool isNumber = false;
+        double width = part.toDouble(&isNumber);
+        if (!isNumber || width <= 0.0) {
+            QMessageBox::warning(this, "警告", QString("无法识别的打印宽度: %1").arg(part));
+            return;
+        }
+        if (!widthsCm.contains(width)) widthsCm.append(width);
+    }
+    std::sort(widthsCm.begin(), widthsCm.end(), std::greater<double>());
+
+    // 每个尺寸都按物理参数计算像素尺寸
+    QList<QSize> pixelSizes;
+    QString sizeReport;
+    for (double widthCm : widthsCm) {
+        QSize pixelSize = calculateTargetPixels(widthCm, firstImageSize);
+        if (pixelSize.width() < 1 || pixelSize.height() < 1) {
+            QMessageBox::warning(this, "警告", QString("打印宽度 %1 厘米过小！").arg(widthCm));
+            return;
+        }
+        QSizeF physicalSize = calculatePhysicalSize(pixelSize);
+        pixelSizes.append(pixelSize);
+        sizeReport += QString("%1 x %2 厘米  →  %3 x %4 像素\n")
+                          .arg(QString::number(physicalSize.width(), 'f', 2))
+                          .arg(QString::number(physicalSize.height(), 'f', 2))
+                          .arg(pixelSize.width())
+                          .arg(pixelSize.height());
+    }
+
+    double requiredDpi = calculateRequiredDPI();
+    QString reportText = QString("将同时生成以下 %1 个尺寸，每帧只解码一次：\n\n%2\n打印机精度要求: %3 DPI")
+                             .arg(widthsCm.size())
+                             .arg(sizeReport)
+                             .arg(static_cast<int>(round(requiredDpi)));
+    if (QMessageBox::question(this, "最终确认", reportText, "生成", "取消") == 1) {
+        return;
+    }
+
+    // 选择基础文件名，各尺寸的文件名追加宽度后缀
+    QString selectedFilter = pngFilter;
+    QString basePath = QFileDialog::getSaveFileName(this, "保存光栅图像（基础文件名）", "", QString(pngFilter) + ";;" + cmykTiffFilter + ";;" + rgbTiffFilter + ";;" + cmykPdfFilter + ";;" + rgbPdfFilter, &selectedFilter);
+    if (basePath.isEmpty()) return;
+
+    RenderSettings settings;
+    settings.imagePaths = imagePaths;
+    settings.frameHolds = frameHolds;
+    settings.frameTransforms = frameTransforms;
+    settings.isVertical = verticalRadio->isChecked();
+    settings.sliceWidth = sliceWidthSpinBox->value();
+    settings.isGrid = gridRadio->isChecked();
+    settings.gridColumns = gridColumns;
+    settings.sliceHeight = gridSliceHeight;
+    settings.outputDpi = requiredDpi;
+    applyRenderOptions(settings);
+    if (!chooseOutputFormat(basePath, selectedFilter, settings.outputFormat, settings.outputIccProfile)) return;
+
+    QFileInfo baseInfo(basePath);
+    QString suffix = baseInfo.suffix();
+    if (suffix.isEmpty()) {
+        suffix = "tif";
+        if (settings.outputFormat == OutputFormat::Png) suffix = "png";
+        if (settings.outputFormat == OutputFormat::CmykPdf || settings.outputFormat == OutputFormat::RgbPdf) suffix = "pdf";
+    }
+    QStringList savedPaths;
+    for (int i = 0; i < widthsCm.size(); ++i) {
+        QString path = QString("%1/%2_%3cm.%4").arg(baseInfo.absolutePath(), baseInfo.completeBaseName(),
+                                                    QString::number(widthsCm[i], 'f', 2), suffix);
+        settings.targets.append(RenderTarget{pixelSizes[i], path});
+        savedPaths.append(path);
+    }
+
+    // 渲染在后台进行，期间可以继续准备下一个任务
+    enqueueRender(settings, QString("%1 等 %2 个尺寸").arg(QFileInfo(savedPaths.first()).fileName()).arg(savedPaths.size()));
+}
+
+void MainWindow::generateCalibrationSheet()
+{
+    if (imagePaths.isEmpty()) {
+        QMessageBox::warning(this, "警告", "请先导入用于测试的图像帧！");
+        return;
+    }
+
+    // 创建参数对话框
+    QDialog dialog(this);
+    dialog.setWindowTitle("生成LPI校准测试页");
+    QFormLayout* formLayout = new QFormLayout(&dialog);
+
+    auto createSpinBox = [&dialog](double minimum, double maximum, double value, int decimals, const QString& suffix) {
+        QDoubleSpinBox* spinBox = new QDoubleSpinBox(&dialog);
+        spinBox->setDecimals(decimals);
+        spinBox->setRange(minimum, maximum);
+        spinBox->setValue(value);
+        spinBox->setSuffix(suffix);
+        return spinBox;
+    };
+
+    // 默认以光栅板实际LPI为中心，上下各测试1 LPI
+    const double centerLpi = actualLpiSpinBox->value();
+    QDoubleSpinBox* startLpiSpinBox = createSpinBox(10.0, 1000.0, centerLpi - 1.0, 2, " LPI");
+    QDoubleSpinBox* endLpiSpinBox = createSpinBox(10.0, 1000.0, centerLpi + 1.0, 2, " LPI");
+    QDoubleSpinBox* stepSpinBox = createSpinBox(0.01, 10.0, 0.10, 2, " LPI");
+    QDoubleSpinBox* dpiSpinBox = createSpinBox(72.0, 4800.0, round(calculateRequiredDPI()), 0, " DPI");
+    QDoubleSpinBox* pageWidthSpinBox = createSpinBox(1.0, 200.0, 21.0, 2, " 厘米");
+    QDoubleSpinBox* pageHeightSpinBox = createSpinBox(1.0, 200.0, 29.7, 2, " 厘米");
+
+    formLayout->addRow("起始LPI:", startLpiSpinBox);
+    formLayout->addRow("结束LPI:", endLpiSpinBox);
+    formLayout->addRow("LPI步长:", stepSpinBox);
+    formLayout->addRow("打印分辨率:", dpiSpinBox);
+    formLayout->addRow("页面宽度:", pageWidthSpinBox);
+    formLayout->addRow("页面高度:", pageHeightSpinBox);
+    // 二维交错的透镜单元是正方形，两个方向的间距相同，按纵向光栅测出水平方向的LPI即可
+    const bool isGrid = gridRadio->isChecked();
+    const QString directionText = isGrid ? "二维交错时按纵向生成，测出水平方向的LPI，垂直方向与之相同"
+                                         : (verticalRadio->isChecked() ? "纵向" : "横向");
+    formLayout->addRow(new QLabel(QString("切分方向沿用当前设置（%1），测试帧为当前导入的 %2 张图像。")
+                                      .arg(directionText)
+                                      .arg(frameSlotCount()), &dialog));
+
+    QDialogButtonBox* buttonBox = new QDialogButtonBox(QDialogButtonBox::Ok | QDialogButtonBox::Cancel, &dialog);
+    connect(buttonBox, &QDialogButtonBox::accepted, &dialog, &QDialog::accept);
+    connect(buttonBox, &QDialogButtonBox::rejected, &dialog, &QDialog::reject);
+    formLayout->addRow(buttonBox);
+
+    if (dialog.exec() != QDialog::Accepted) return;
+
+    CalibrationSheetSettings settings;
+    for (int i : frameSlotSequence(frameHolds, imagePaths.size())) settings.imagePaths.append(imagePaths[i]);
+    settings.isVertical = isGrid || verticalRadio->isChecked();
+    settings.pageWidthCm = pageWidthSpinBox->value();
+    settings.pageHeightCm = pageHeightSpinBox->value();
+    settings.dpi = dpiSpinBox->value();
+    settings.startLpi = startLpiSpinBox->value();
+    settings.endLpi = endLpiSpinBox->value();
+    settings.lpiStep = stepSpinBox->value();
+
+    CalibrationSheetRenderer renderer(settings);
+    const QList<double> lpis = renderer.lpiValues();
+    const int bandCount = lpis.size();
+    if (bandCount == 0) {
+        QMessageBox::warning(this, "警告", "结束LPI不能小于起始LPI！");
+        return;
+    }
+    if (renderer.requestedBandCount() > bandCount) {
+        const QString message = QString("所选LPI范围共有 %1 个条带，超过了测试页最多容纳的 %2 个。\n\n"
+                                        "将只生成 %3 ~ %4 LPI 的条带，是否继续？\n(也可以取消后增大步长或缩小范围)")
+                                    .arg(renderer.requestedBandCount())
+                                    .arg(CalibrationSheetRenderer::maxBandCount)
+                                    .arg(QString::number(lpis.first(), 'f', 3))
+                                    .arg(QString::number(lpis.last(), 'f', 3));
+        if (QMessageBox::question(this, "条带数量超出上限", message, "继续", "取消") == 1) return;
+    }
+
+    QString savePath = QFileDialog::getSaveFileName(this, "保存LPI校准测试页", "", "PNG图像 (*.png)");
+    if (savePath.isEmpty()) return;
+
+    try
+    {
+        QProgressDialog progress("正在生成校准测试页...", "取消", 0, 100, this);
+        progress.setWindowModality(Qt::WindowModal);
+        progress.setMinimumDuration(0);
+
+        QImage sheet = renderer.render(makeProgressCallback(progress));
+        if (sheet.isNull()) return;
+
+        if (!sheet.save(savePath, "PNG")) {
+            throw std::runtime_error("保存测试页失败！请检查路径或权限。");
+        }
+
+        QMessageBox::information(this, "成功", QString("校准测试页已保存至:\n%1\n\n共 %2 个条带，请按 %3 x %4 厘米原尺寸打印，"
+                                                      "在光栅板下找到效果最好的条带，其标注值即为打印机校准LPI。")
+                                                  .arg(savePath)
+                                                  .arg(bandCount)
+                                                  .arg(QString::number(settings.pageWidthCm, 'f', 2))
+                                                  .arg(QString::number(settings.pageHeightCm, 'f', 2)));
+    }
+    catch (const std::exception &e)
+    {
+        QMessageBox::critical(this, "处理出错", e.what());
+    }
+}
+
+void MainWindow::imposeCardsOnSheet()
+{
+    // 创建参数对话框
+    QDialog dialog(this);
+    dialog.setWindowTitle("N拼版到印刷纸");
+    QFormLayout* formLayout = new QFormLayout(&dialog);
+
+    // 卡片列表：可以是之前任意一次输出的光栅图像
+    QListWidget* cardListWidget = new QListWidget(&dialog);
+    cardListWidget->setMinimumHeight(120);
+    QPushButton* addCardButton = new QPushButton("添加卡片...", &dialog);
+    QPushButton* removeCardButton = new QPushButton("移除", &dialog);
+    QHBoxLayout* cardButtonLayout = new QHBoxLayout();
+    cardButtonLayout->addWidget(addCardButton);
+    cardButtonLayout->addWidget(removeCardButton);
+    cardButtonLayout->addStretch();
+    connect(addCardButton, &QPushButton::clicked, &dialog, [&dialog, cardListWidget]() {
+        QStringList files = QFileDialog::getOpenFileNames(&dialog, "选择已合成的光栅卡", "", "图像文件 (*.png *.tif *.tiff *.jpg *.jpeg)");
+        cardListWidget->addItems(files);
+    });
+    connect(removeCardButton, &QPushButton::clicked, &dialog, [cardListWidget]() {
+        delete cardListWidget->takeItem(cardListWidget->currentRow());
+    });
+
+    auto createSpinBox = [&dialog](double minimum, double maximum, double value, int decimals, const QString& suffix) {
+        QDoubleSpinBox* spinBox = new QDoubleSpinBox(&dialog);
+        spinBox->setDecimals(decimals);
+        spinBox->setRange(minimum, maximum);
+        spinBox->setValue(value);
+        spinBox->setSuffix(suffix);
+        return spinBox;
+    };
+
+    ImpositionSettings defaults;
+    QSpinBox* copiesSpinBox = new QSpinBox(&dialog);
+    copiesSpinBox->setRange(0, 999);
+    copiesSpinBox->setValue(defaults.copiesPerCard);
+    copiesSpinBox->setSpecialValueText("自动排满");
+    QDoubleSpinBox* sheetWidthSpinBox = createSpinBox(1.0, 500.0, defaults.sheetWidthCm, 2, " 厘米");
+    QDoubleSpinBox* sheetHeightSpinBox = createSpinBox(1.0, 500.0, defaults.sheetHeightCm, 2, " 厘米");
+    QDoubleSpinBox* marginSpinBox = createSpinBox(0.0, 50.0, defaults.marginCm, 2, " 厘米");
+    QDoubleSpinBox* gutterSpinBox = createSpinBox(0.0, 50.0, defaults.gutterCm, 2, " 厘米");
+    // 卡片按原像素放置，纸张分辨率应与生成卡片时的打印分辨率一致
+    const double currentDpi = round(calculateRequiredDPI());
+    QDoubleSpinBox* dpiSpinBox = createSpinBox(72.0, 4800.0, currentDpi > 0 ? currentDpi : defaults.dpi, 0, " DPI");
+    QDoubleSpinBox* lpiSpinBox = createSpinBox(10.0, 1000.0, calibratedLpiSpinBox->value(), 3, " LPI");
+    QCheckBox* cropMarksCheckBox = new QCheckBox("绘制裁切线", &dialog);
+    cropMarksCheckBox->setChecked(defaults.cropMarks);
+
+    formLayout->addRow("光栅卡:", cardListWidget);
+    formLayout->addRow("", cardButtonLayout);
+    formLayout->addRow("每张卡片份数:", copiesSpinBox);
+    formLayout->addRow("纸张宽度:", sheetWidthSpinBox);
+    formLayout->addRow("纸张高度:", sheetHeightSpinBox);
+    formLayout->addRow("四周留白:", marginSpinBox);
+    formLayout->addRow("卡片间隔:", gutterSpinBox);
+    formLayout->addRow("打印分辨率:", dpiSpinBox);
+    formLayout->addRow("校准LPI:", lpiSpinBox);
+    formLayout->addRow("", cropMarksCheckBox);
+    const QString directionText = gridRadio->isChecked() ? "二维，卡片的横纵位置都对齐到透镜间距"
+                                                         : (verticalRadio->isChecked() ? "纵向" : "横向");
+    formLayout->addRow(new QLabel(QString("光栅方向沿用当前设置（%1），卡片按原像素放置，不重新缩放。")
+                                      .arg(directionText), &dialog));
+
+    QDialogButtonBox* buttonBox = new QDialogButtonBox(QDialogButtonBox::Ok | QDialogButtonBox::Cancel, &dialog);
+    connect(buttonBox, &QDialogButtonBox::accepted, &dialog, &QDialog::accept);
+    connect(buttonBox, &QDialogButtonBox::rejected, &dialog, &QDialog::reject);
+    formLayout->addRow(buttonBox);
+
+    if (dialog.exec() != QDialog::Accepted) return;
+
+    ImpositionSettings settings;
+    for (int i = 0; i < cardListWidget->count(); ++i) {
+        settings.cardPaths.append(cardListWidget->item(i)->text());
+    }
+    if (settings.cardPaths.isEmpty()) {
+        QMessageBox::warning(this, "警告", "请至少添加一张光栅卡！");
+        return;
+    }
+    settings.copiesPerCard = copiesSpinBox->value();
+    settings.sheetWidthCm = sheetWidthSpinBox->value();
+    settings.sheetHeightCm = sheetHeightSpinBox->value();
+    settings.marginCm = marginSpinBox->value();
+    settings.gutterCm = gutterSpinBox->value();
+    settings.dpi = dpiSpinBox->value();
+    settings.lpi = lpiSpinBox->value();
+    settings.isVertical = verticalRadio->isChecked();
+    settings.isGrid = gridRadio->isChecked();
+    settings.cropMarks = cropMarksCheckBox->isChecked();
+
+    // 只读取文件头获取尺寸，先给出排版结果供用户确认
+    QList<QSize> cardSizes;
+    for (const QString& path : settings.cardPaths) {
+        QImageReader reader(path);
+        reader.setAutoTransform(true);
+        const QSize size = reader.size();
+        if (!size.isValid()) {
+            QMessageBox::critical(this, "错误", "无法读取卡片图像:\n" + path);
+            return;
+        }
+        cardSizes.append(size);
+    }
+
+    SheetImposer imposer(settings);
+    const int placementCount = imposer.layout(cardSizes).size();
+    if (placementCount == 0) {
+        QMessageBox::warning(this, "警告", "纸张上放不下指定的卡片，请调整纸张尺寸、留白或份数。");
+        return;
+    }
+    const QSize sheetSize = imposer.sheetPixelSize();
+    QString capNote;
+    if (settings.copiesPerCard <= 0 && placementCount >= SheetImposer::maxFillPlacements) {
+        capNote = QString("\n\n注意: 自动排满最多排列 %1 张卡片，已达到上限，纸张上可能仍有空位。")
+                      .arg(SheetImposer::maxFillPlacements);
+    }
+    QString reportText = QString("将在 %1 x %2 厘米的纸张上排列 %3 张卡片。\n\n"
+                                 "输出像素尺寸: %4 x %5 像素\n打印分辨率: %6 DPI%7\n\n是否继续？")
+                             .arg(QString::number(settings.sheetWidthCm, 'f', 2))
+                             .arg(QString::number(settings.sheetHeightCm, 'f', 2))
+                             .arg(placementCount)
+                             .arg(sheetSize.width())
+                             .arg(sheetSize.height())
+                             .arg(static_cast<int>(settings.dpi))
+                             .arg(capNote);
+    if (QMessageBox::question(this, "拼版确认", reportText, "生成", "取消") == 1) {
+        return;
+    }
+
+    // 整张纸可能非常大，只提供可流式写出的TIFF格式
+    QString selectedFilter = rgbTiffFilter;
+    settings.savePath = QFileDialog::getSaveFileName(this, "保存拼版文件", "", QString(rgbTiffFilter) + ";;" + cmykTiffFilter, &selectedFilter);
+    if (settings.savePath.isEmpty()) return;
+    // 文件名带其他后缀时补上.tif，避免把TIFF数据写进名为.pdf或.png的文件
+    const QString suffix = QFileInfo(settings.savePath).suffix().toLower();
+    if (suffix != "tif" && suffix != "tiff") {
+        settings.savePath += ".tif";
+        if (QFileInfo::exists(settings.savePath) &&
+            QMessageBox::question(this, "文件已存在", QString("拼版只能保存为TIFF格式，文件名已改为:\n%1\n\n该文件已存在，是否覆盖？").arg(settings.savePath),
+                                  "覆盖", "取消") == 1) {
+            return;
+        }
+    }
+    if (!chooseOutputFormat(settings.savePath, selectedFilter, settings.outputFormat, settings.outputIccProfile)) return;
+
+    try
+    {
+        QProgressDialog progress("正在拼版...", "取消", 0, 100, this);
+        progress.setWindowModality(Qt::WindowModal);
+        progress.setMinimumDuration(0);
+
+        if (!SheetImposer(settings).run(makeProgressCallback(progress))) return;
+
+        QMessageBox::information(this, "成功", QString("拼版文件已保存至:\n%1\n\n共 %2 张卡片，请按原尺寸打印，并使用 %3 LPI 的整张光栅板覆盖。")
+                                                  .arg(settings.savePath)
+                                                  .arg(placementCount)
+                                                  .arg(QString::number(settings.lpi, 'f', 3)));
+    }
+    catch (const std::exception &e)
+    {
+        QMessageBox::critical(this, "处理出错", e.what());
+    }
+}
+
+void MainWindow::resumeInterruptedRenders()
+{
+    const QList<RenderJournal::PendingJob> jobs = RenderJournal::pendingJobs();
+    for (const RenderJournal::PendingJob& job : jobs) {
+        const RenderSettings& settings = job.settings;
+        QStringList savePaths;
+        for (const RenderTarget& target : settings.targets) savePaths.append(target.savePath);
+
+        // 源文件被修改过的任务无法续接，已写出的未完成文件保留给用户自行处理
+        if (!job.resumable) {
+            const int choice = QMessageBox::question(this, "无法续接的渲染任务",
+                                                     QString("上次未完成的渲染任务的源文件已被修改，无法从中断处继续:\n%1\n\n"
+                                                             "已写出的部分保留在同名的 .part 文件中。是否清理该任务的临时数据？")
+                                                         .arg(savePaths.join("\n")),
+                                                     "稍后", "清理");
+            if (choice == 1) RenderJournal::discard(job, false);
+            continue;
+        }
+
+        const int choice = QMessageBox::question(this, "未完成的渲染任务",
+                                                 QString("发现上次未完成的渲染任务（%1 帧）:\n%2\n\n是否从中断处继续？")
+                                                     .arg(settings.imagePaths.size())
+                                                     .arg(savePaths.join("\n")),
+                                                 "继续", "稍后", "放弃");
+        if (choice == 1) continue;
+        if (choice == 2) {
+            RenderJournal::discard(job, true);
+            continue;
+        }
+
+        enqueueRender(settings, QString("续接: %1").arg(QFileInfo(savePaths.first()).fileName()));
+    }
+}
+
+void MainWindow::enqueueRender(const RenderSettings& settings, const QString& description)
+{
+    renderQueue->enqueue(settings, description);
+    showRenderQueuePanel();
+}
+
+void MainWindow::applyRenderOptions(RenderSettings& settings) const
+{
+    settings.scratchCodec = scratchCodec;
+    settings.largePageBuffers = largePageBuffers;
+    settings.sharpenAmount = sharpenPercent / 100.0;
+    settings.sharpenRadius = sharpenRadius;
+    settings.linearLightScaling = linearLightScaling;
+    settings.alignFrames = alignFrames;
+    settings.crosstalk = crosstalkPercent / 100.0;
+    settings.inBetweenFrames = inBetweenFrames;
+    settings.interpolation = interpolationMode;
+}
+
+void MainWindow::editRenderOptions()
+{
+    QDialog dialog(this);
+    dialog.setWindowTitle("渲染选项");
+    QFormLayout* formLayout = new QFormLayout(&dialog);
+
+    QCheckBox* compressScratchCheckBox = new QCheckBox("压缩临时文件", &dialog);
+    compressScratchCheckBox->setChecked(scratchCodec == ScratchCodec::Deflate);
+    compressScratchCheckBox->setToolTip("预处理后的帧按块压缩后写入临时文件，合成时只解压需要的块。\n"
+                                        "临时文件的读写量和占用空间通常可减少一半以上，代价是少量CPU占用。\n"
+                                        "临时目录位于高速SSD时可以关闭。");
+    formLayout->addRow("临时文件:", compressScratchCheckBox);
+
+    QCheckBox* largePagesCheckBox = new QCheckBox("大页内存与NUMA本地分配", &dialog);
+    largePagesCheckBox->setChecked(largePageBuffers);
+    largePagesCheckBox->setToolTip("结果图使用2MB大页，减少TLB缺失；各条带的内存由合成它的线程首次写入，\n"
+                                   "在多路服务器上落在该线程所在的NUMA节点，减少跨节点的内存访问。\n"
+                                   "系统不支持时自动使用普通内存。");
+    formLayout->addRow("内存:", largePagesCheckBox);
+
+    QCheckBox* alignFramesCheckBox = new QCheckBox("自动对齐各帧", &dialog);
+    alignFramesCheckBox->setChecked(alignFrames);
+    alignFramesCheckBox->setToolTip("估计每帧相对第一帧的微小平移并在缩放时校正，消除手持拍摄造成的重影。\n"
+                                    "各帧只保留共有的画面部分，边缘会略微裁掉。");
+    formLayout->addRow("帧对齐:", alignFramesCheckBox);
+
+    QDoubleSpinBox* crosstalkSpinBox = new QDoubleSpinBox(&dialog);
+    crosstalkSpinBox->setRange(0.0, LenticularRenderer::maxCrosstalk * 100.0);
+    crosstalkSpinBox->setDecimals(1);
+    crosstalkSpinBox->setSingleStep(0.5);
+    crosstalkSpinBox->setSuffix(" %");
+    crosstalkSpinBox->setValue(crosstalkPercent);
+    crosstalkSpinBox->setToolTip("从每个切片中减去相邻两帧各该比例的内容，抵消光栅板的串扰(重影)。\n"
+                                 "0为不补偿。可先用小尺寸测试卡找到重影刚好消失的数值。");
+    formLayout->addRow("串扰补偿:", crosstalkSpinBox);
+
+    QCheckBox* linearLightCheckBox = new QCheckBox("在线性光空间中缩放", &dialog);
+    linearLightCheckBox->setChecked(linearLightScaling);
+    linearLightCheckBox->setToolTip("先把sRGB颜色换算为线性光再缩放，最后换算回sRGB。\n"
+                                    "大图缩小到打印尺寸时，细线、文字等细节不会变暗，颜色不会偏移。耗时与直接缩放相差不大。");
+    formLayout->addRow("缩放:", linearLightCheckBox);
+
+    QDoubleSpinBox* sharpenAmountSpinBox = new QDoubleSpinBox(&dialog);
+    sharpenAmountSpinBox->setRange(0.0, 300.0);
+    sharpenAmountSpinBox->setDecimals(0);
+    sharpenAmountSpinBox->setSingleStep(10.0);
+    sharpenAmountSpinBox->setSuffix(" %");
+    sharpenAmountSpinBox->setValue(sharpenPercent);
+    sharpenAmountSpinBox->setToolTip("缩放后对每帧做USM锐化，补偿缩小和光栅板造成的模糊。0为不锐化。\n"
+                                     "锐化在缩放的同时完成，不需要在其他软件中另外处理每一帧。");
+    formLayout->addRow("锐化强度:", sharpenAmountSpinBox);
+
+    QDoubleSpinBox* sharpenRadiusSpinBox = new QDoubleSpinBox(&dialog);
+    sharpenRadiusSpinBox->setRange(0.3, FrameSharpener::maxRadius);
+    sharpenRadiusSpinBox->setDecimals(1);
+    sharpenRadiusSpinBox->setSingleStep(0.1);
+    sharpenRadiusSpinBox->setSuffix(" 像素");
+    sharpenRadiusSpinBox->setValue(sharpenRadius);
+    sharpenRadiusSpinBox->setToolTip("锐化的半径，以输出图像的像素计，通常取0.5~1.5像素。");
+    formLayout->addRow("锐化半径:", sharpenRadiusSpinBox);
+
+    QSpinBox* inBetweenSpinBox = new QSpinBox(&dialog);
+    inBetweenSpinBox->setRange(0, 16);
+    inBetweenSpinBox->setValue(inBetweenFrames);
+    inBetweenSpinBox->setToolTip("在每两张相邻的导入帧之间合成的中间帧数，使翻转和变形动画更平滑。\n"
+                                 "中间帧在合成时按条带生成，不会写出文件。帧数增加后，打印机精度要求随之提高。");
+    formLayout->addRow("中间帧数:", inBetweenSpinBox);
+
+    QComboBox* interpolationComboBox = new QComboBox(&dialog);
+    interpolationComboBox->addItems({"交叉淡化", "块匹配运动估计"});
+    interpolationComboBox->setCurrentIndex(interpolationMode == InterpolationMode::BlockMatching ? 1 : 0);
+    interpolationComboBox->setToolTip("交叉淡化：按位置混合前后两帧，速度最快，适合变色和淡入淡出。\n"
+                                      "块匹配运动估计：估计画面中物体的移动，再把前后两帧移到中间位置混合，适合平移和3D效果。");
+    formLayout->addRow("中间帧合成:", interpolationComboBox);
+    formLayout->addRow(new QLabel("选项对之后加入队列的渲染任务生效。", &dialog));
+
+    QDialogButtonBox* buttonBox = new QDialogButtonBox(QDialogButtonBox::Ok | QDialogButtonBox::Cancel, &dialog);
+    connect(buttonBox, &QDialogButtonBox::accepted, &dialog, &QDialog::accept);
+    connect(buttonBox, &QDialogButtonBox::rejected, &dialog, &QDialog::reject);
+    formLayout->addRow(buttonBox);
+
+    if (dialog.exec() != QDialog::Accepted) return;
+
+    scratchCodec = compressScratchCheckBox->isChecked() ? ScratchCodec::Deflate : ScratchCodec::Raw;
+    largePageBuffers = largePagesCheckBox->isChecked();
+    sharpenPercent = sharpenAmountSpinBox->value();
+    sharpenRadius = sharpenRadiusSpinBox->value();
+    linearLightScaling = linearLightCheckBox->isChecked();
+    alignFrames = alignFramesCheckBox->isChecked();
+    crosstalkPercent = crosstalkSpinBox->value();
+    const InterpolationMode previousMode = interpolationMode;
+    interpolationMode = interpolationComboBox->currentIndex() == 1 ? InterpolationMode::BlockMatching : InterpolationMode::CrossFade;
+
+    // 中间帧数改变了每个光栅单元下的帧数，与修改切片宽度一样需要重新计算尺寸
+    if (inBetweenSpinBox->value() != inBetweenFrames) {
+        inBetweenFrames = inBetweenSpinBox->value();
+        onCoreParametersChanged(true);
+    } else if (inBetweenFrames > 0 && interpolationMode != previousMode) {
+        // 预览中的中间帧按合成方式生成
+        schedulePreviewUpdate();
+    }
+}
+
+void MainWindow::editGridSettings()
+{
+    QDialog dialog(this);
+    dialog.setWindowTitle("二维交错设置");
+    QFormLayout* formLayout = new QFormLayout(&dialog);
+
+    QSpinBox* columnsSpinBox = new QSpinBox(&dialog);
+    columnsSpinBox->setRange(0, 64);
+    columnsSpinBox->setSpecialValueText("自动");
+    columnsSpinBox->setValue(gridColumns);
+    columnsSpinBox->setToolTip("每个透镜单元水平方向的视点数N。帧按行优先填入N列的矩阵，行数M由帧数决定。\n"
+                               "自动时取接近正方形的矩阵。");
+    formLayout->addRow("水平视点数:", columnsSpinBox);
+
+    QSpinBox* sliceHeightSpinBox = new QSpinBox(&dialog);
+    sliceHeightSpinBox->setRange(0, 200);
+    sliceHeightSpinBox->setSpecialValueText("自动");
+    sliceHeightSpinBox->setSuffix(" 像素");
+    sliceHeightSpinBox->setValue(gridSliceHeight);
+    sliceHeightSpinBox->setToolTip("每个切片的像素高度。自动时使透镜单元的高度尽量等于宽度，\n"
+                                   "适用于横纵间距相同的微透镜阵列。");
+    formLayout->addRow("切片高度:", sliceHeightSpinBox);
+
+    // 按当前帧数和打印参数显示得到的视点矩阵，间距不一致时可据此调整
+    QLabel* summaryLabel = new QLabel(&dialog);
+    auto updateSummary = [&]() {
+        const InterleaveGrid grid = InterleaveGrid::resolve(outputFrameCount(), columnsSpinBox->value(),
+                                                            sliceWidthSpinBox->value(), sliceHeightSpinBox->value());
+        const QSize cell = grid.cellSize(sliceWidthSpinBox->value());
+        const double dpi = cell.width() * calibratedLpiSpinBox->value();
+        QString summary = QString("视点矩阵: %1 x %2 (共 %3 帧)\n透镜单元: %4 x %5 像素\n垂直方向LPI: %6 (水平方向 %7)")
+                              .arg(grid.columns).arg(grid.rows).arg(outputFrameCount())
+                              .arg(cell.width()).arg(cell.height())
+                              .arg(QString::number(dpi / cell.height(), 'f', 2))
+                              .arg(QString::number(calibratedLpiSpinBox->value(), 'f', 2));
+        // 自动高度只有在指定的水平视点数过少时才做不到正方形，提示用户调整
+        if (sliceHeightSpinBox->value() == 0 && !grid.isSquare(sliceWidthSpinBox->value())) {
+            summary += "\n注意: 当前的水平视点数和切片宽度无法得到正方形的透镜单元，请增加水平视点数或手动指定切片高度。";
+        }
+        summaryLabel->setText(summary);
+    };
+    updateSummary();
+    connect(columnsSpinBox, QOverload<int>::of(&QSpinBox::valueChanged), &dialog, updateSummary);
+    connect(sliceHeightSpinBox, QOverload<int>::of(&QSpinBox::valueChanged), &dialog, updateSummary);
+    formLayout->addRow(summaryLabel);
+    formLayout->addRow(new QLabel("在“切分方向”中选择“二维”后生效。", &dialog));
+
+    QDialogButtonBox* buttonBox = new QDialogButtonBox(QDialogButtonBox::Ok | QDialogButtonBox::Cancel, &dialog);
+    connect(buttonBox, &QDialogButtonBox::accepted, &dialog, &QDialog::accept);
+    connect(buttonBox, &QDialogButtonBox::rejected, &dialog, &QDialog::reject);
+    formLayout->addRow(buttonBox);
+
+    if (dialog.exec() != QDialog::Accepted) return;
+    if (columnsSpinBox->value() == gridColumns && sliceHeightSpinBox->value() == gridSliceHeight) return;
+
+    gridColumns = columnsSpinBox->value();
+    gridSliceHeight = sliceHeightSpinBox->value();
+
+    // 视点矩阵决定透镜单元的尺寸，与修改切片宽度一样需要重新计算尺寸
+    if (gridRadio->isChecked()) onCoreParametersChanged(true);
+}
+
+void MainWindow::showRenderQueuePanel()
+{
+    renderQueuePanel->show();
+    renderQueuePanel->raise();
+}
+
+void MainWindow::onRenderJobFinished(int jobId, RenderJobState state, const QString& message)
+{
+    // 成功和取消只在任务面板中显示，不打断正在进行的操作；出错时才弹窗
+    if (state != RenderJobState::Failed) {
+        if (state == RenderJobState::Finished) showRenderQueuePanel();
+        return;
+    }
+    const RenderJob job = renderQueue->job(jobId);
+    QMessageBox::critical(this, "处理出错", QString("渲染任务“%1”出错:\n%2\n\n%3").arg(job.description, message, resumeHint));
+}
+
 void MainWindow::onPrintSizeEditingFinished()
 {
     desiredPrintSizeSpinBox->blockSignals(true);
@@ -330,9 +1024,9 @@ void MainWindow::onPrintSizeEditingFinished()
     } else {
         // 自动模式，与程序自动计算的精确值比较
         if (!imagePaths.isEmpty()) {
-            QImage firstImage(imagePaths.first());
-            if(!firstImage.isNull()) {
-                previousValue = calculatePhysicalSize(firstImage.size()).width();
+            const QSize firstImageSize = firstFrameSize();
+            if(!firstImageSize.isEmpty()) {
+                previousValue = calculatePhysicalSize(automaticPixelSize(firstImageSize)).width();
             }
         }
     }
@@ -344,10 +1038,10 @@ void MainWindow::onPrintSizeEditingFinished()
         return;
     }
 
-    QImage firstImage(imagePaths.first());
-    if (firstImage.isNull()) return;
+    const QSize firstImageSize = firstFrameSize();
+    if (firstImageSize.isEmpty()) return;
 
-    QSize targetPixelSize = calculateTargetPixels(userInputWidth, firstImage.size());
+    QSize targetPixelSize = calculateTargetPixels(userInputWidth, firstImageSize);
     if (targetPixelSize.width() < 1) {
         QMessageBox::warning(this, "警告", "宽度过小！");
         return;
@@ -384,24 +1078,29 @@ void MainWindow::saveFinalImage()
     }
 
     // 收集所有参数
-    QImage firstImage(imagePaths.first());
-    if(firstImage.isNull()) {
+    const QSize firstImageSize = firstFrameSize();
+    if(firstImageSize.isEmpty()) {
         QMessageBox::critical(this, "错误", "无法加载第一张图像以获取尺寸信息。");
         return;
     }
 
     int frameCount = imagePaths.size();
     QString direction = verticalRadio->isChecked() ? "纵向" : "横向";
-    int sliceWidth = sliceWidthSpinBox->value();
+    QString sliceText = QString::number(sliceWidthSpinBox->value());
+    if (gridRadio->isChecked()) {
+        const InterleaveGrid grid = currentGrid();
+        direction = QString("二维 (每个透镜单元 %1 x %2 个视点)").arg(grid.columns).arg(grid.rows);
+        sliceText += QString(" (高 %1)").arg(grid.sliceHeight);
+    }
 
     double desiredSize = desiredPrintSizeSpinBox->value();
 
     // 确定最终尺寸
     QSize finalImageSize;
     if (currentSizeMode == SizeMode::ManualOverride) {
-        finalImageSize = calculateTargetPixels(manualPrintWidthCm, firstImage.size());
+        finalImageSize = calculateTargetPixels(manualPrintWidthCm, firstImageSize);
     } else {
-        finalImageSize = firstImage.size();
+        finalImageSize = automaticPixelSize(firstImageSize);
     }
 
     if (finalImageSize.width() < 1 || finalImageSize.height() < 1) {
@@ -413,6 +1112,15 @@ void MainWindow::saveFinalImage()
     double requiredDpi = calculateRequiredDPI();
 
     // 创建并显示报告单
+    QStringList frameDetails;
+    if (frameSlotCount() != imagePaths.size()) {
+        frameDetails.append(QString("导入 %1 张，按停留次数展开为 %2 个位置").arg(imagePaths.size()).arg(frameSlotCount()));
+    } else if (inBetweenFrames > 0) {
+        frameDetails.append(QString("导入 %1 张").arg(imagePaths.size()));
+    }
+    if (inBetweenFrames > 0) frameDetails.append(QString("合成中间帧 %1 张").arg(outputFrameCount() - frameSlotCount()));
+    QString frameCountText = QString::number(outputFrameCount());
+    if (!frameDetails.isEmpty()) frameCountText += QString(" (%1)").arg(frameDetails.join("，"));
     QString reportText = QString(
                              "请确认以下参数是否正确:"
                              "\n\n"
@@ -423,9 +1131,9 @@ void MainWindow::saveFinalImage()
                              "输出图像尺寸: %4 x %5 像素 \n"
                              "物理打印尺寸: %6 x %7 厘米 \n"
                              "打印机精度要求: %8 DPI \n"
-                             ).arg(imagePaths.size())
-                             .arg(verticalRadio->isChecked() ? "纵向" : "横向")
-                             .arg(sliceWidthSpinBox->value())
+                             ).arg(frameCountText)
+                             .arg(direction)
+                             .arg(sliceText)
                              .arg(finalImageSize.width())
                              .arg(finalImageSize.height())
                              .arg(QString::number(finalPhysicalSize.width(), 'f', 2))
@@ -455,105 +1163,27 @@ void MainWindow::saveFinalImage()
         }
     }
 
-    // 获取保存路径并执行最终的后台处理
-    QString savePath = QFileDialog::getSaveFileName(this, "保存光栅图像", "", "PNG图像 (*.png)");
+    // 获取保存路径和输出格式
+    QString selectedFilter = pngFilter;
+    QString savePath = QFileDialog::getSaveFileName(this, "保存光栅图像", "", QString(pngFilter) + ";;" + cmykTiffFilter + ";;" + rgbTiffFilter + ";;" + cmykPdfFilter + ";;" + rgbPdfFilter, &selectedFilter);
     if (savePath.isEmpty()) return;
 
-    // --- 核心处理阶段 ---
-
-    QList<QFile*> tempFiles;
-
-    try
-    {
-        QTemporaryDir tempDir;
-        if (!tempDir.isValid()) throw std::runtime_error("无法创建用于处理图像的临时目录。");
-        qDebug() << "使用临时目录:" << tempDir.path();
-
-        QProgressDialog progress("正在处理...", "取消", 0, 100, this);
-        progress.setWindowModality(Qt::WindowModal);
-        progress.setMinimumDuration(0);
-
-        // --- 阶段一: 预处理并保存为临时文件 ---
-        QList<QString> tempImagePaths;
-        progress.setLabelText(QString("正在处理1/2: 预处理源图像 (共 %1 张)").arg(imagePaths.size()));
-        for (int i = 0; i < imagePaths.size(); ++i) {
-            progress.setValue(static_cast<int>((i * 1.0 / imagePaths.size()) * 50.0));
-            QApplication::processEvents();
-            if (progress.wasCanceled()) return;
-            {
-                QImage originalImg(imagePaths[i]);
-                if (originalImg.isNull()) throw std::runtime_error("无法加载源文件。");
-
-                QImage scaledImg = originalImg.scaled(finalImageSize, Qt::IgnoreAspectRatio, Qt::SmoothTransformation)
-                                       .convertToFormat(QImage::Format_ARGB32);
-                if (scaledImg.isNull()) throw std::runtime_error("在缩放图像时内存不足。");
-
-                QString tempPath = tempDir.path() + QString("/scaled_%1.raw").arg(i);
-                QFile tempFile(tempPath);
-                if (!tempFile.open(QIODevice::WriteOnly)) throw std::runtime_error("无法创建临时文件。");
-
-                tempFile.write(reinterpret_cast<const char*>(scaledImg.bits()), scaledImg.sizeInBytes());
-                tempFile.close();
-                tempImagePaths.append(tempPath);
-            }
-        }
-
-        // --- 阶段二: 从临时文件合成 ---
-        progress.setLabelText(QString("正在处理2/2: 合成最终图像..."));
-
-        QImage resultImage(finalImageSize, QImage::Format_ARGB32);
-        if (resultImage.isNull()) throw std::bad_alloc();
-
-        // 一次性打开所有临时文件以供读取，并将文件指针存入列表
-        for(const QString& path : tempImagePaths) {
-            QFile* file = new QFile(path);
-            if (!file->open(QIODevice::ReadOnly)) {
-                throw std::runtime_error("无法打开预处理后的临时文件。");
-            }
-            tempFiles.append(file);
-        }
-
-        const qint64 bytesPerLine = finalImageSize.width() * 4;
-
-        // 逐行处理
-        for (int y = 0; y < finalImageSize.height(); ++y) {
-            progress.setValue(50 + static_cast<int>((y * 1.0 / finalImageSize.height()) * 50.0));
-            if(y % 16 == 0) QApplication::processEvents();
-            if (progress.wasCanceled()) {
-                qDeleteAll(tempFiles);
-                return;
-            }
-
-            // 为当前行，从每个临时文件中读取对应的行数据
-            QList<QByteArray> sourceScanlines;
-            for(QFile* file : tempFiles) {
-                file->seek(y * bytesPerLine); // 直接跳转到行开头，极快
-                sourceScanlines.append(file->read(bytesPerLine));
-            }
-
-            // 调用合成算法
-            generateLenticularStrip(resultImage, sourceScanlines, y, 1, verticalRadio->isChecked(), sliceWidthSpinBox->value());
-        }
-
-        // 清理文件句柄
-        for(auto file : tempFiles) file->close();
-        qDeleteAll(tempFiles);
-
-        // 保存最终结果
-        progress.setValue(100);
-        if (!resultImage.save(savePath, "PNG", 80)) {
-            throw std::runtime_error("保存最终文件失败！请检查路径或权限。");
-        }
-
-        QMessageBox::information(this, "成功", QString("图像已成功保存至:\n%1").arg(savePath));
-    }
-    catch (const std::exception &e)
-    {
-        // 确保即使发生异常，也关闭并清理已打开的文件
-        for(auto file : tempFiles) file->close();
-        qDeleteAll(tempFiles);
-        QMessageBox::critical(this, "处理出错", e.what());
-    }
+    RenderSettings settings;
+    settings.imagePaths = imagePaths;
+    settings.frameHolds = frameHolds;
+    settings.frameTransforms = frameTransforms;
+    settings.targets.append(RenderTarget{finalImageSize, savePath});
+    settings.isVertical = verticalRadio->isChecked();
+    settings.sliceWidth = sliceWidthSpinBox->value();
+    settings.isGrid = gridRadio->isChecked();
+    settings.gridColumns = gridColumns;
+    settings.sliceHeight = gridSliceHeight;
+    settings.outputDpi = requiredDpi;
+    applyRenderOptions(settings);
+    if (!chooseOutputFormat(savePath, selectedFilter, settings.outputFormat, settings.outputIccProfile)) return;
+
+    // --- 核心处理阶段：加入后台渲染队列 ---
+    enqueueRender(settings, QFileInfo(savePath).fileName());
 }
 
 
@@ -580,6 +1210,8 @@ void MainWindow::deleteSelectedImage()
     int selectionAnchor = rowsToDelete.last();
     for(int row : rowsToDelete) {
         imagePaths.removeAt(row);
+        frameHolds.removeAt(row);
+        frameTransforms.removeAt(row);
     }
 
     updateImageList();
@@ -619,6 +1251,8 @@ void MainWindow::moveImageUp()
     const QSize oldFirstImageSize = oldFirstImageReader.size();
 
     imagePaths.swapItemsAt(currentIndex, currentIndex - 1);
+    frameHolds.swapItemsAt(currentIndex, currentIndex - 1);
+    frameTransforms.swapItemsAt(currentIndex, currentIndex - 1);
     updateImageList();
     imageListWidget->setCurrentRow(currentIndex - 1);
 
@@ -642,6 +1276,8 @@ void MainWindow::moveImageDown()
     const QSize oldFirstImageSize = oldFirstImageReader.size();
 
     imagePaths.swapItemsAt(currentIndex, currentIndex + 1);
+    frameHolds.swapItemsAt(currentIndex, currentIndex + 1);
+    frameTransforms.swapItemsAt(currentIndex, currentIndex + 1);
     updateImageList();
     imageListWidget->setCurrentRow(currentIndex + 1);
 
@@ -656,6 +1292,129 @@ void MainWindow::moveImageDown()
     }
 }
 
+void MainWindow::editFrameHold(QListWidgetItem* item)
+{
+    const int row = imageListWidget->row(item);
+    if (row < 0 || row >= imagePaths.size()) return;
+
+    bool ok = false;
+    const int hold = QInputDialog::getInt(this, "停留次数",
+                                          QString("“%1”在每个光栅单元中占用的切片位置数：\n"
+                                                  "例如设为3，该帧的画面会在翻转时停留三个位置。").arg(QFileInfo(imagePaths[row]).fileName()),
+                                          frameHolds[row], 1, 99, 1, &ok);
+    if (!ok || hold == frameHolds[row]) return;
+
+    frameHolds[row] = hold;
+    updateImageList();
+    imageListWidget->setCurrentRow(row);
+
+    // 帧数变化会改变打印精度要求，与修改切片宽度一样重置尺寸
+    onCoreParametersChanged(true);
+}
+
+void MainWindow::showImageListMenu(const QPoint& position)
+{
+    QListWidgetItem* item = imageListWidget->itemAt(position);
+    if (!item) return;
+    const int row = imageListWidget->row(item);
+
+    QMenu menu(this);
+    QAction* holdAction = menu.addAction("停留次数...");
+    QAction* transformAction = menu.addAction("调整画面(裁切/平移/旋转)...");
+    QAction* resetAction = menu.addAction("恢复原始画面");
+    resetAction->setEnabled(!frameTransforms[row].isIdentity());
+
+    QAction* chosen = menu.exec(imageListWidget->viewport()->mapToGlobal(position));
+    if (chosen == holdAction) {
+        editFrameHold(item);
+    } else if (chosen == transformAction) {
+        editFrameTransform(row);
+    } else if (chosen == resetAction) {
+        frameTransforms[row] = FrameTransform();
+        updateImageList();
+        imageListWidget->setCurrentRow(row);
+        // 第一帧的取景决定输出尺寸
+        if (row == 0) {
+            onCoreParametersChanged(true);
+        } else {
+            schedulePreviewUpdate();
+        }
+    }
+}
+
+void MainWindow::editFrameTransform(int row)
+{
+    if (row < 0 || row >= imagePaths.size()) return;
+    const FrameTransform current = frameTransforms[row];
+
+    QDialog dialog(this);
+    dialog.setWindowTitle(QString("调整画面 - %1").arg(QFileInfo(imagePaths[row]).fileName()));
+    QFormLayout* formLayout = new QFormLayout(&dialog);
+
+    // 裁切与平移以源图像宽高的百分比输入
+    auto addPercentRow = [&](const QString& label, double minimum, double maximum, double value) {
+        QDoubleSpinBox* spinBox = new QDoubleSpinBox(&dialog);
+        spinBox->setRange(minimum, maximum);
+        spinBox->setDecimals(2);
+        spinBox->setSingleStep(0.5);
+        spinBox->setSuffix(" %");
+        spinBox->setValue(value * 100.0);
+        formLayout->addRow(label, spinBox);
+        return spinBox;
+    };
+    QDoubleSpinBox* cropLeftSpinBox = addPercentRow("取景左边:", 0.0, 99.0, current.crop.x());
+    QDoubleSpinBox* cropTopSpinBox = addPercentRow("取景上边:", 0.0, 99.0, current.crop.y());
+    QDoubleSpinBox* cropWidthSpinBox = addPercentRow("取景宽度:", 1.0, 100.0, current.crop.width());
+    QDoubleSpinBox* cropHeightSpinBox = addPercentRow("取景高度:", 1.0, 100.0, current.crop.height());
+    QDoubleSpinBox* panXSpinBox = addPercentRow("水平平移:", -50.0, 50.0, current.pan.x());
+    QDoubleSpinBox* panYSpinBox = addPercentRow("垂直平移:", -50.0, 50.0, current.pan.y());
+    cropWidthSpinBox->setToolTip("取景区域按原比例铺满输出画面，宽高比与输出不同时两侧会被居中裁掉，画面不会变形。");
+    panXSpinBox->setToolTip("取景区域的平移，正值向右/向下。超出源图像的部分填充白色。");
+
+    QDoubleSpinBox* rotationSpinBox = new QDoubleSpinBox(&dialog);
+    rotationSpinBox->setRange(-180.0, 180.0);
+    rotationSpinBox->setDecimals(2);
+    rotationSpinBox->setSingleStep(0.1);
+    rotationSpinBox->setSuffix(" 度");
+    rotationSpinBox->setValue(current.rotation);
+    rotationSpinBox->setToolTip("画面绕取景区域中心顺时针旋转的角度，用于校正拍摄时的倾斜。");
+    formLayout->addRow("旋转:", rotationSpinBox);
+
+    QCheckBox* exifCheckBox = new QCheckBox("按照片的EXIF方向信息摆正", &dialog);
+    exifCheckBox->setChecked(current.exifOrientation);
+    formLayout->addRow("方向:", exifCheckBox);
+    formLayout->addRow(new QLabel("调整不修改源文件，只在预览和最终渲染时应用。", &dialog));
+
+    QDialogButtonBox* buttonBox = new QDialogButtonBox(QDialogButtonBox::Ok | QDialogButtonBox::Cancel, &dialog);
+    connect(buttonBox, &QDialogButtonBox::accepted, &dialog, &QDialog::accept);
+    connect(buttonBox, &QDialogButtonBox::rejected, &dialog, &QDialog::reject);
+    formLayout->addRow(buttonBox);
+
+    if (dialog.exec() != QDialog::Accepted) return;
+
+    FrameTransform transform;
+    const double cropX = cropLeftSpinBox->value() / 100.0;
+    const double cropY = cropTopSpinBox->value() / 100.0;
+    transform.crop = QRectF(cropX, cropY,
+                            qMin(cropWidthSpinBox->value() / 100.0, 1.0 - cropX),
+                            qMin(cropHeightSpinBox->value() / 100.0, 1.0 - cropY));
+    transform.pan = QPointF(panXSpinBox->value() / 100.0, panYSpinBox->value() / 100.0);
+    transform.rotation = rotationSpinBox->value();
+    transform.exifOrientation = exifCheckBox->isChecked();
+    if (transform.cacheKey() == current.cacheKey()) return;
+
+    frameTransforms[row] = transform;
+    updateImageList();
+    imageListWidget->setCurrentRow(row);
+
+    // 第一帧的取景决定输出图像的宽高比，需要与修改其他核心参数一样重新计算尺寸
+    if (row == 0) {
+        onCoreParametersChanged(true);
+    } else {
+        schedulePreviewUpdate();
+    }
+}
+
 // ===================================================================
 //          核心辅助与计算函数
 // ===================================================================
@@ -666,15 +1425,20 @@ QSize MainWindow::calculateTargetPixels(double physical_width_cm, const QSize& o
 
     double aspectRatio = static_cast<double>(original_image_size.height()) / original_image_size.width();
     double calLpi = calibratedLpiSpinBox->value();
-    int sliceWidth = sliceWidthSpinBox->value();
-    int numFrames = imagePaths.size();
 
-    double total_pixels_per_lenticule = sliceWidth * numFrames;
+    double total_pixels_per_lenticule = lenticulePixels();
     double required_print_dpi = total_pixels_per_lenticule * calLpi;
     double physical_size_inch = physical_width_cm / 2.54;
     double calculated_pixels_w = physical_size_inch * required_print_dpi;
     double calculated_pixels_h = calculated_pixels_w * aspectRatio;
 
+    // 二维交错时两个方向都排列着透镜，宽和高都取整到完整的透镜单元，边缘不会出现不完整的视点矩阵
+    if (gridRadio->isChecked()) {
+        const QSize cell_size = currentGrid().cellSize(sliceWidthSpinBox->value());
+        calculated_pixels_w = qMax(1.0, round(calculated_pixels_w / cell_size.width())) * cell_size.width();
+        calculated_pixels_h = qMax(1.0, round(calculated_pixels_h / cell_size.height())) * cell_size.height();
+    }
+
     return QSize(static_cast<int>(round(calculated_pixels_w)), static_cast<int>(round(calculated_pixels_h)));
 }
 
@@ -685,10 +1449,8 @@ QSizeF MainWindow::calculatePhysicalSize(const QSize& current_pixel_size)
     double aspectRatio = static_cast<double>(current_pixel_size.height()) / current_pixel_size.width();
     double total_pixels_w = current_pixel_size.width();
     double calLpi = calibratedLpiSpinBox->value();
-    int sliceWidth = sliceWidthSpinBox->value();
-    int numFrames = imagePaths.size();
 
-    double total_pixels_per_lenticule = sliceWidth * numFrames;
+    double total_pixels_per_lenticule = lenticulePixels();
     double required_print_dpi = total_pixels_per_lenticule * calLpi;
 
     if (required_print_dpi <= 0) return QSizeF(0.0, 0.0);
@@ -700,6 +1462,84 @@ QSizeF MainWindow::calculatePhysicalSize(const QSize& current_pixel_size)
     return QSizeF(physical_size_cm_w, physical_size_cm_h);
 }
 
+bool MainWindow::chooseOutputFormat(const QString& savePath, const QString& selectedFilter,
+                                    OutputFormat& outputFormat, QByteArray& outputIccProfile)
+{
+    // 只有明确选择了CMYK过滤器才输出CMYK；其他过滤器下只按后缀选择RGB格式，不提示选择ICC配置文件
+    if (selectedFilter != cmykTiffFilter && selectedFilter != cmykPdfFilter) {
+        const QString suffix = QFileInfo(savePath).suffix().toLower();
+        if (selectedFilter == rgbPdfFilter || (selectedFilter != rgbTiffFilter && suffix == "pdf")) {
+            outputFormat = OutputFormat::RgbPdf;
+        } else if (selectedFilter == rgbTiffFilter || suffix == "tif" || suffix == "tiff") {
+            outputFormat = OutputFormat::RgbTiff;
+        } else {
+            outputFormat = OutputFormat::Png;
+        }
+        return true;
+    }
+
+    // CMYK输出需要印刷厂提供的输出ICC配置文件
+    QString iccPath = QFileDialog::getOpenFileName(this, "选择输出ICC配置文件", "", "ICC配置文件 (*.icc *.icm)");
+    if (iccPath.isEmpty()) return false;
+
+    QFile iccFile(iccPath);
+    if (!iccFile.open(QIODevice::ReadOnly)) {
+        QMessageBox::critical(this, "错误", "无法读取所选的ICC配置文件。");
+        return false;
+    }
+    outputFormat = (selectedFilter == cmykPdfFilter) ? OutputFormat::CmykPdf : OutputFormat::CmykTiff;
+    outputIccProfile = iccFile.readAll();
+    return true;
+}
+
+LenticularRenderer::ProgressCallback MainWindow::makeProgressCallback(QProgressDialog& progress)
+{
+    return [&progress](int percent, const QString& stage) {
+        progress.setLabelText(stage);
+        progress.setValue(percent);
+        QApplication::processEvents();
+        return !progress.wasCanceled();
+    };
+}
+
+int MainWindow::frameSlotCount() const
+{
+    return frameSlotSequence(frameHolds, imagePaths.size()).size();
+}
+
+QSize MainWindow::firstFrameSize() const
+{
+    if (imagePaths.isEmpty()) return QSize();
+    const FrameTransform& transform = frameTransforms.first();
+    return transform.framedSize(FrameTransformer::orientedSize(imagePaths.first(), transform.exifOrientation));
+}
+
+int MainWindow::outputFrameCount() const
+{
+    return FrameInterpolator::totalFrameCount(frameSlotCount(), inBetweenFrames);
+}
+
+InterleaveGrid MainWindow::currentGrid() const
+{
+    return InterleaveGrid::resolve(outputFrameCount(), gridColumns, sliceWidthSpinBox->value(), gridSliceHeight);
+}
+
+int MainWindow::lenticulePixels() const
+{
+    // 二维交错时每个透镜单元水平方向只有N个视点，其余视点排在垂直方向
+    const int columns = gridRadio->isChecked() ? currentGrid().columns : outputFrameCount();
+    return sliceWidthSpinBox->value() * columns;
+}
+
+QSize MainWindow::automaticPixelSize(const QSize& firstImageSize) const
+{
+    // 与手动输入打印宽度时一样，二维交错的边缘不出现不完整的视点矩阵
+    if (!gridRadio->isChecked() || firstImageSize.isEmpty()) return firstImageSize;
+    const QSize cell = currentGrid().cellSize(sliceWidthSpinBox->value());
+    return QSize(qMax(1, qRound(double(firstImageSize.width()) / cell.width())) * cell.width(),
+                 qMax(1, qRound(double(firstImageSize.height()) / cell.height())) * cell.height());
+}
+
 double MainWindow::calculateRequiredDPI()
 {
     if (imagePaths.isEmpty()) {
@@ -707,10 +1547,8 @@ double MainWindow::calculateRequiredDPI()
     }
 
     double calLpi = calibratedLpiSpinBox->value();
-    int sliceWidth = sliceWidthSpinBox->value();
-    int numFrames = imagePaths.size();
     // 每个光栅单元下的总像素数
-    double total_pixels_per_lenticule = sliceWidth * numFrames;
+    double total_pixels_per_lenticule = lenticulePixels();
 
     return total_pixels_per_lenticule * calLpi;
 }
@@ -719,9 +1557,12 @@ void MainWindow::updateImageList()
 {
     disconnect(imageListWidget, &QListWidget::itemSelectionChanged, this, &MainWindow::updateButtonStates);
     imageListWidget->clear();
-    for (const QString& path : imagePaths) {
-        QFileInfo fileInfo(path);
-        QListWidgetItem* item = new QListWidgetItem(QIcon(path), fileInfo.fileName());
+    for (int i = 0; i < imagePaths.size(); ++i) {
+        QFileInfo fileInfo(imagePaths[i]);
+        QString text = fileInfo.fileName();
+        if (frameHolds[i] > 1) text += QString("  (停留 %1 次)").arg(frameHolds[i]);
+        if (!frameTransforms[i].isIdentity()) text += "  (已调整画面)";
+        QListWidgetItem* item = new QListWidgetItem(QIcon(imagePaths[i]), text);
         imageListWidget->addItem(item);
     }
     connect(imageListWidget, &QListWidget::itemSelectionChanged, this, &MainWindow::updateButtonStates);
@@ -753,8 +1594,8 @@ void MainWindow::updateAndShowPreview()
         return;
     }
 
-    QImage firstImage(imagePaths.first());
-    if(firstImage.isNull()) return;
+    const QSize firstImageSize = firstFrameSize();
+    if(firstImageSize.isEmpty()) return;
 
     QSize finalPixelSize;
     double displayPhysicalWidth;
@@ -763,10 +1604,10 @@ void MainWindow::updateAndShowPreview()
     if (currentSizeMode == SizeMode::ManualOverride) {
         // 手动模式
         displayPhysicalWidth = manualPrintWidthCm;
-        finalPixelSize = calculateTargetPixels(displayPhysicalWidth, firstImage.size());
+        finalPixelSize = calculateTargetPixels(displayPhysicalWidth, firstImageSize);
     } else {
         // 自动模式
-        finalPixelSize = firstImage.size();
+        finalPixelSize = automaticPixelSize(firstImageSize);
         displayPhysicalWidth = calculatePhysicalSize(finalPixelSize).width();
     }
 
@@ -781,24 +1622,73 @@ void MainWindow::updateAndShowPreview()
     QSize previewTargetSize = finalPixelSize;
     previewTargetSize.scale(previewSize, previewSize, Qt::KeepAspectRatio);
 
+    // 停留多次的帧只解码一次，各位置共享同一张缩略图
+    QHash<QString, QImage> thumbnailOfFrame;
     QList<QImage> previewThumbnails;
-    for(const QString& path : imagePaths) {
-        QImage img(path);
-        if(!img.isNull()){
-            // 所有缩略图基于统一的目标尺寸生成，保证一致性
-            previewThumbnails.append(img.scaled(previewTargetSize, Qt::IgnoreAspectRatio, Qt::SmoothTransformation));
+    QList<QString> previewFrameKeys;
+    for (int i : frameSlotSequence(frameHolds, imagePaths.size())) {
+        const QString& path = imagePaths[i];
+        const QString frameKey = path + "|" + frameTransforms[i].cacheKey();
+        if (!thumbnailOfFrame.contains(frameKey)) {
+            QImage thumbnail;
+            if (frameTransforms[i].isIdentity()) {
+                QImageReader reader(path);
+                reader.setAutoTransform(true);
+                const QImage img = reader.read();
+                // 所有缩略图基于统一的目标尺寸生成，保证一致性
+                if (!img.isNull()) thumbnail = img.scaled(previewTargetSize, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+            } else {
+                // 有画面调整的帧与最终渲染一样只解码取景区域，预览与输出的取景一致
+                try {
+                    thumbnail = FrameTransformer::render(path, frameTransforms[i], QRectF(0.0, 0.0, 1.0, 1.0), {previewTargetSize}).first();
+                } catch (const std::exception&) {
+                }
+            }
+            thumbnailOfFrame.insert(frameKey, thumbnail);
+        }
+        if (!thumbnailOfFrame.value(frameKey).isNull()) {
+            previewThumbnails.append(thumbnailOfFrame.value(frameKey).convertToFormat(QImage::Format_ARGB32));
+            previewFrameKeys.append(frameKey);
         }
     }
     if (previewThumbnails.isEmpty()) return;
 
-    // 合成并显示预览
-    QImage previewImage = generateLenticularPreview(previewThumbnails, verticalRadio->isChecked(), sliceWidthSpinBox->value());
+    // 与最终渲染一样在相邻的帧之间合成中间帧，预览的帧序列与输出一致。缩略图很小，整幅作为一个条带合成
+    if (inBetweenFrames > 0) {
+        QList<QImage> withInBetweens;
+        for (qsizetype s = 0; s < previewThumbnails.size(); ++s) {
+            const QImage& current = previewThumbnails[s];
+            withInBetweens.append(current);
+            if (s + 1 >= previewThumbnails.size()) continue;
+
+            // 停留的帧之间没有变化，中间帧就是该帧本身
+            if (previewFrameKeys[s + 1] == previewFrameKeys[s]) {
+                for (int k = 0; k < inBetweenFrames; ++k) withInBetweens.append(current);
+                continue;
+            }
+            const QImage& next = previewThumbnails[s + 1];
+            const QList<QByteArray> synthesized = FrameInterpolator::synthesizeBand(
+                current.constBits(), next.constBits(), current.width(), current.height(), 0, current.height(),
+                inBetweenFrames, interpolationMode);
+            for (const QByteArray& pixels : synthesized) {
+                withInBetweens.append(QImage(reinterpret_cast<const uchar*>(pixels.constData()), current.width(), current.height(),
+                                             qsizetype(current.width()) * 4, QImage::Format_ARGB32).copy());
+            }
+        }
+        previewThumbnails = withInBetweens;
+    }
+
+    // 合成并显示预览。视点矩阵按实际参与合成的缩略图数确定，矩阵中的每个位置都对应一张缩略图
+    const InterleaveGrid grid = InterleaveGrid::resolve(previewThumbnails.size(), gridColumns, sliceWidthSpinBox->value(), gridSliceHeight);
+    QImage previewImage = generateLenticularPreview(previewThumbnails, verticalRadio->isChecked(), sliceWidthSpinBox->value(),
+                                                    gridRadio->isChecked() ? &grid : nullptr);
     if(!previewImage.isNull()){
         previewLabel->setPixmap(QPixmap::fromImage(previewImage));
     }
 }
 
-QImage MainWindow::generateLenticularPreview(const QList<QImage>& thumbnailImages, bool isVertical, int sliceWidth)
+QImage MainWindow::generateLenticularPreview(const QList<QImage>& thumbnailImages, bool isVertical, int sliceWidth,
+                                             const InterleaveGrid* grid)
 {
     if (thumbnailImages.isEmpty() || sliceWidth <= 0) return QImage();
 
@@ -812,7 +1702,16 @@ QImage MainWindow::generateLenticularPreview(const QList<QImage>& thumbnailImage
 
     QImage resultImage(targetSize, QImage::Format_ARGB32);
 
-    if (isVertical) {
+    if (grid) {
+        for (int y = 0; y < targetSize.height(); ++y) {
+            QRgb* resultLine = reinterpret_cast<QRgb*>(resultImage.scanLine(y));
+            const int sliceRow = y / grid->sliceHeight;
+            for (int x = 0; x < targetSize.width(); ++x) {
+                int sourceImageIndex = grid->frameAt(x / sliceWidth, sliceRow, numFrames);
+                memcpy(resultLine + x, sourceImages[sourceImageIndex].constScanLine(y) + x * 4, 4);
+            }
+        }
+    } else if (isVertical) {
         for (int y = 0; y < targetSize.height(); ++y) {
             QRgb* resultLine = reinterpret_cast<QRgb*>(resultImage.scanLine(y));
             QList<const uchar*> sourceLines;
@@ -836,29 +1735,6 @@ QImage MainWindow::generateLenticularPreview(const QList<QImage>& thumbnailImage
     return resultImage;
 }
 
-void MainWindow::generateLenticularStrip(QImage& resultImage, const QList<QByteArray>& sourceScanlines, int y, int stripHeight, bool isVertical, int sliceWidth)
-{
-    Q_UNUSED(stripHeight); // 在逐行模型中，此参数固定为1，因此标记为未使用
-    if (sourceScanlines.isEmpty() || sliceWidth <= 0) return;
-
-    const int numFrames = sourceScanlines.size();
-    const int width = resultImage.width();
-    const int bytesPerPixel = 4; // ARGB32格式
-    uchar* resultLine = resultImage.scanLine(y);
-
-    if (isVertical) {
-        for (int x = 0; x < width; ++x) {
-            int sourceImageIndex = (x / sliceWidth) % numFrames;
-            // 从对应的源数据行中，复制4个字节（一个像素）
-            memcpy(resultLine + (x * bytesPerPixel), sourceScanlines[sourceImageIndex].constData() + (x * bytesPerPixel), bytesPerPixel);
-        }
-    } else { // 横向切分
-        int sourceImageIndex = (y / sliceWidth) % numFrames;
-        // 将一整行裸数据直接复制过去
-        memcpy(resultLine, sourceScanlines[sourceImageIndex].constData(), resultImage.bytesPerLine());
-    }
-}
-
 void MainWindow::onResetPrintSizeClicked()
 {
     qDebug() << "用户点击重置，打印尺寸恢复为自动计算模式。";
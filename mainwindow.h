@@ -7,15 +7,23 @@
 #include <QString>
 #include <QImage>
 #include <QSize>
+#include "lenticularrenderer.h"
+#include "renderqueue.h"
 
 // 前向声明
 class QLabel;
 class QPushButton;
 class QListWidget;
 class QRadioButton;
+class QListWidgetItem;
 class QSpinBox;
 class QScrollArea;
 class QDoubleSpinBox;
+class QProgressDialog;
+class QMenu;
+class QAction;
+class QCloseEvent;
+class RenderQueuePanel;
 
 enum class SizeMode {
     Automatic,
@@ -44,6 +52,12 @@ public:
      */
     ~MainWindow();
 
+protected:
+    /**
+     * @brief 关闭窗口前，如有后台渲染任务则请用户确认，并等待当前任务保存检查点。
+     */
+    void closeEvent(QCloseEvent* event) override;
+
 private slots:
 
     /**
@@ -66,6 +80,21 @@ private slots:
      */
     void moveImageDown();
 
+    /**
+     * @brief 响应双击列表项，设置该帧的停留次数(在每个光栅单元中占用的切片位置数)。
+     */
+    void editFrameHold(QListWidgetItem* item);
+
+    /**
+     * @brief 在图像列表中右键单击时弹出菜单：停留次数、画面调整、恢复原始画面。
+     */
+    void showImageListMenu(const QPoint& position);
+
+    /**
+     * @brief 设置一帧的画面调整(裁切、平移、旋转、EXIF方向)。调整不修改源文件，只在渲染和预览时应用。
+     */
+    void editFrameTransform(int row);
+
     /**
      * @brief 响应“生成并保存”按钮点击，执行最终的合成与保存流程。
      * 包含逆运算逻辑：如果未指定物理尺寸，会计算并推荐尺寸。
@@ -98,6 +127,45 @@ private slots:
      */
     void showHelpDialog();
 
+    /**
+     * @brief 响应“多尺寸批量输出”菜单项，一次解码同时生成多个打印宽度的光栅图像。
+     */
+    void saveMultipleSizes();
+
+    /**
+     * @brief 响应“生成LPI校准测试页”菜单项，在一张页面上生成一组不同LPI的测试条带。
+     */
+    void generateCalibrationSheet();
+
+    /**
+     * @brief 响应“N拼版到印刷纸”菜单项，将多张光栅卡按光栅单元对齐排到一张印刷纸上。
+     */
+    void imposeCardsOnSheet();
+
+    /**
+     * @brief 启动时检查上次中断的渲染任务，询问用户是否从检查点继续。
+     */
+    void resumeInterruptedRenders();
+
+    /**
+     * @brief 响应“渲染选项”菜单项，设置之后的渲染任务使用的性能选项。
+     */
+    void editRenderOptions();
+
+    /**
+     * @brief 响应“二维交错设置”菜单项，设置蝇眼/微透镜阵列的视点矩阵和切片高度。
+     */
+    void editGridSettings();
+
+    /**
+     * @brief 显示后台渲染任务面板。
+     */
+    void showRenderQueuePanel();
+
+    /**
+     * @brief 后台渲染任务结束时调用，出错时弹窗提示。
+     */
+    void onRenderJobFinished(int jobId, RenderJobState state, const QString& message);
 
 
 private:
@@ -106,18 +174,33 @@ private:
     /// @brief 存储用户导入的原始图像的文件路径。这是所有数据的“源头”。
     QList<QString> imagePaths;
 
+    /// @brief 与imagePaths一一对应，每帧的停留次数。同一帧停留多次只解码一次。
+    QList<int> frameHolds;
+
+    /// @brief 与imagePaths一一对应，每帧的画面调整。
+    QList<FrameTransform> frameTransforms;
+
     // === UI控件成员变量 ===
     QScrollArea* scrollArea;
     QLabel* previewLabel;
     QLabel* outputPixelSizeLabel;
     QPushButton* importButton;
     QPushButton* helpButton;
+    QPushButton* toolsButton;
+    QMenu* toolsMenu;
+    QAction* multiSizeAction;
+    QAction* calibrationSheetAction;
+    QAction* impositionAction;
+    QAction* renderOptionsAction;
+    QAction* renderQueueAction;
+    QAction* gridSettingsAction;
     QListWidget* imageListWidget;
     QPushButton* moveUpButton;
     QPushButton* moveDownButton;
     QPushButton* deleteButton;
     QRadioButton* verticalRadio;
     QRadioButton* horizontalRadio;
+    QRadioButton* gridRadio;
     QSpinBox* sliceWidthSpinBox;
     QDoubleSpinBox* desiredPrintSizeSpinBox;
     QPushButton* resetPrintSizeButton;
@@ -125,6 +208,25 @@ private:
     QDoubleSpinBox* calibratedLpiSpinBox;
     QPushButton* saveButton;
 
+    // === 后台渲染 ===
+    RenderQueue* renderQueue;
+    RenderQueuePanel* renderQueuePanel;
+
+    // === 渲染选项，创建新任务时写入任务参数 ===
+    ScratchCodec scratchCodec = ScratchCodec::Deflate;
+    bool alignFrames = false;
+    double crosstalkPercent = 0.0;
+    int inBetweenFrames = 0;
+    InterpolationMode interpolationMode = InterpolationMode::CrossFade;
+    bool largePageBuffers = false;
+    double sharpenPercent = 0.0;
+    double sharpenRadius = 1.0;
+    bool linearLightScaling = false;
+
+    // === 二维交错参数，0为自动 ===
+    int gridColumns = 0;
+    int gridSliceHeight = 0;
+
     // === 内部辅助函数 ===
 
     /**
@@ -155,24 +257,67 @@ private:
     /**
      * @brief 用于生成预览图的函数
      */
-    QImage generateLenticularPreview(const QList<QImage>& thumbnailImages, bool isVertical, int sliceWidth);
+    QImage generateLenticularPreview(const QList<QImage>& thumbnailImages, bool isVertical, int sliceWidth,
+                                     const InterleaveGrid* grid = nullptr);
 
     /**
-     * @brief 根据当前参数计算对打印机的最终DPI精度要求。
+     * @brief 根据保存对话框选择的过滤器或文件后缀确定输出格式。
+     * 只有选择CMYK过滤器时才输出CMYK并请用户选择ICC配置文件；其他过滤器下按后缀选择PNG、RGB TIFF或RGB PDF。
+     * @return 用户取消或读取ICC配置文件失败时返回false。
      */
-    double calculateRequiredDPI();
+    bool chooseOutputFormat(const QString& savePath, const QString& selectedFilter,
+                            OutputFormat& outputFormat, QByteArray& outputIccProfile);
+
+    /**
+     * @brief 创建驱动模态进度对话框的进度回调，供各类渲染器使用。
+     */
+    LenticularRenderer::ProgressCallback makeProgressCallback(QProgressDialog& progress);
+
+    /**
+     * @brief 将最终渲染加入后台队列并显示任务面板，立即返回。
+     */
+    void enqueueRender(const RenderSettings& settings, const QString& description);
+
+    /**
+     * @brief 将“渲染选项”中的设置写入新任务的参数。续接的任务沿用原来的参数，不经过这里。
+     */
+    void applyRenderOptions(RenderSettings& settings) const;
+
+    /**
+     * @brief 按停留次数展开后的切片位置数，不含中间帧。
+     */
+    int frameSlotCount() const;
 
     /**
-     * @brief 【核心算法】用源图像的裸数据行(sourceScanlines)填充目标大图(resultImage)的指定行。
-     * @param resultImage 对最终结果图像的引用，此函数将直接在上面填充像素。
-     * @param sourceScanlines 包含了所有源图像【单行】裸像素数据的列表。
-     * @param y 正在处理的行在目标图像中的Y坐标。
-     * @param stripHeight 此参数在此模型中固定为1。
-     * @param isVertical 是否为纵向切分。
-     * @param sliceWidth 每个切片的像素宽度。
+     * @brief 第一帧应用画面调整后的像素尺寸，决定输出图像的宽高比。只读取文件头，不解码像素。
+     * @return 无法读取时返回空尺寸。
      */
-    void generateLenticularStrip(QImage& resultImage, const QList<QByteArray>& sourceScanlines, int y, int stripHeight, bool isVertical, int sliceWidth);
+    QSize firstFrameSize() const;
 
+    /**
+     * @brief 每个光栅单元下的帧数：按停留次数展开的帧加上合成的中间帧。
+     */
+    int outputFrameCount() const;
+
+    /**
+     * @brief 按当前帧数和二维交错参数确定的视点矩阵。
+     */
+    InterleaveGrid currentGrid() const;
+
+    /**
+     * @brief 每个光栅单元(二维交错时为透镜单元)水平方向的像素数，乘以LPI即为打印机精度要求。
+     */
+    int lenticulePixels() const;
+
+    /**
+     * @brief 自动尺寸模式下的输出像素尺寸：第一帧的尺寸，二维交错时宽和高取整到完整的透镜单元。
+     */
+    QSize automaticPixelSize(const QSize& firstImageSize) const;
+
+    /**
+     * @brief 根据当前参数计算对打印机的最终DPI精度要求。
+     */
+    double calculateRequiredDPI();
 
     /**
      * @brief 【核心计算】根据物理参数计算目标像素尺寸。
@@ -0,0 +1,314 @@
+#include "pdfwriter.h"
+
+#include <QRegularExpression>
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+/// @brief 文件头。第二行的高位字节表明文件含有二进制数据；UserUnit需要PDF 1.6
+const QByteArray fileHeader("%PDF-1.6\n%\xE2\xE3\xCF\xD3\n");
+
+/// @brief 每个条带对象末尾的固定内容
+const QByteArray streamEnd("\nendstream\nendobj\n");
+
+/// @brief 交叉引用表使用10位十进制偏移，文件不能超过这个大小
+constexpr qint64 maxXrefOffset = 9999999999LL;
+
+/**
+ * @brief zlib压缩，去掉qCompress()在前面附加的4字节长度，得到FlateDecode可以直接解码的数据。
+ */
+QByteArray flateEncode(const char* data, qsizetype size)
+{
+    const QByteArray compressed = qCompress(reinterpret_cast<const uchar*>(data), size);
+    return compressed.size() > 4 ? compressed.mid(4) : QByteArray();
+}
+
+QByteArray pdfNumber(double value)
+{
+    // PDF不接受指数形式的数字
+    QByteArray text = QByteArray::number(value, 'f', 4);
+    while (text.endsWith('0')) text.chop(1);
+    if (text.endsWith('.')) text.chop(1);
+    return text;
+}
+
+QByteArray objectHeader(int objectNumber)
+{
+    return QByteArray::number(objectNumber) + " 0 obj\n";
+}
+
+} // namespace
+
+PdfStripWriter::~PdfStripWriter()
+{
+    // 未正常close()的文件是不完整的，直接丢弃
+    if (file.isOpen()) abort();
+}
+
+void PdfStripWriter::prepare(const QSize& imageSize, ColorModel colorModel, double dpi, const QByteArray& iccProfile)
+{
+    size = imageSize;
+    model = colorModel;
+    resolutionDpi = dpi > 0.0 ? dpi : 72.0;
+    embeddedProfile = iccProfile;
+    rowsWritten = 0;
+    bandOffsets.clear();
+    bandRows.clear();
+    lastError.clear();
+}
+
+QByteArray PdfStripWriter::buildPreamble() const
+{
+    QByteArray preamble = fileHeader + objectHeader(profileObject);
+    if (embeddedProfile.isEmpty()) {
+        preamble += "null\nendobj\n";
+        return preamble;
+    }
+
+    const QByteArray compressed = flateEncode(embeddedProfile.constData(), embeddedProfile.size());
+    preamble += "<< /N " + QByteArray::number(model == ColorModel::Cmyk ? 4 : 3)
+                + " /Filter /FlateDecode /Length " + QByteArray::number(compressed.size()) + " >>\nstream\n";
+    preamble += compressed;
+    preamble += streamEnd;
+    return preamble;
+}
+
+QByteArray PdfStripWriter::bandDictionary(int bandIndex, int rows, qint64 length) const
+{
+    QByteArray colorSpace;
+    if (!embeddedProfile.isEmpty()) {
+        colorSpace = "[/ICCBased " + QByteArray::number(profileObject) + " 0 R]";
+    } else {
+        colorSpace = (model == ColorModel::Cmyk) ? "/DeviceCMYK" : "/DeviceRGB";
+    }
+
+    // 关闭插值：查看器和RIP放大时不能把相邻切片混在一起
+    return objectHeader(profileObject + 1 + bandIndex)
+           + "<< /Type /XObject /Subtype /Image /Width " + QByteArray::number(size.width())
+           + " /Height " + QByteArray::number(rows)
+           + " /ColorSpace " + colorSpace
+           + " /BitsPerComponent 8 /Interpolate false /Filter /FlateDecode /Length " + QByteArray::number(length)
+           + " >>\nstream\n";
+}
+
+double PdfStripWriter::userUnit() const
+{
+    // 页面边长超过14400点(200英寸)时，许多阅读器和RIP要求用UserUnit放大单位
+    const double longestPoints = qMax(size.width(), size.height()) * 72.0 / resolutionDpi;
+    return qMax(1.0, std::ceil(longestPoints / maxPageExtent));
+}
+
+QSizeF PdfStripWriter::pageSizeCm() const
+{
+    return QSizeF(size.width() * 2.54 / resolutionDpi, size.height() * 2.54 / resolutionDpi);
+}
+
+bool PdfStripWriter::open(const QString& path, const QSize& imageSize, ColorModel colorModel, double dpi, const QByteArray& iccProfile)
+{
+    prepare(imageSize, colorModel, dpi, iccProfile);
+    if (size.isEmpty()) return fail("PDF图像尺寸无效。");
+
+    file.setFileName(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        return fail(QString("无法创建输出文件: %1").arg(file.errorString()));
+    }
+
+    const QByteArray preamble = buildPreamble();
+    if (file.write(preamble) != preamble.size()) {
+        return fail(QString("写入PDF文件头失败: %1").arg(file.errorString()));
+    }
+    return true;
+}
+
+bool PdfStripWriter::resume(const QString& path, const QSize& imageSize, ColorModel colorModel, double dpi,
+                            const QByteArray& iccProfile, int completedRows)
+{
+    prepare(imageSize, colorModel, dpi, iccProfile);
+    if (size.isEmpty() || completedRows < 0 || completedRows > size.height()) return fail("PDF图像尺寸无效。");
+
+    file.setFileName(path);
+    if (!file.open(QIODevice::ReadWrite)) {
+        return fail(QString("无法打开未完成的输出文件: %1").arg(file.errorString()));
+    }
+
+    // 文件头必须与本次参数生成的一致；之后逐个校验条带对象，重建交叉引用表需要的偏移
+    const QByteArray preamble = buildPreamble();
+    if (file.read(preamble.size()) != preamble) {
+        file.close();
+        return fail("未完成的输出文件与当前任务不匹配。");
+    }
+
+    static const QRegularExpression dictionaryPattern("/Height (\\d+) .*/Length (\\d+) >>\nstream\n");
+    qint64 position = preamble.size();
+    while (rowsWritten < completedRows) {
+        const QByteArray head = file.read(512);
+        const int streamStart = head.indexOf(">>\nstream\n");
+        const QRegularExpressionMatch match = dictionaryPattern.match(head.left(streamStart + 10));
+        const int rows = match.hasMatch() ? match.captured(1).toInt() : 0;
+        const qint64 length = match.hasMatch() ? match.captured(2).toLongLong() : 0;
+        const QByteArray dictionary = bandDictionary(bandOffsets.size(), rows, length);
+
+        const qint64 bandEnd = position + dictionary.size() + length + streamEnd.size();
+        if (streamStart < 0 || rows <= 0 || !head.startsWith(dictionary) || bandEnd > file.size()
+            || !file.seek(bandEnd - streamEnd.size()) || file.read(streamEnd.size()) != streamEnd) {
+            file.close();
+            return fail("未完成的输出文件与当前任务不匹配。");
+        }
+
+        bandOffsets.append(position);
+        bandRows.append(rows);
+        rowsWritten += rows;
+        position = bandEnd;
+    }
+
+    if (rowsWritten != completedRows) {
+        file.close();
+        return fail("续接位置不在PDF条带的边界上。");
+    }
+    if (!file.resize(position) || !file.seek(position)) {
+        file.close();
+        return fail(QString("无法截断未完成的输出文件: %1").arg(file.errorString()));
+    }
+    return true;
+}
+
+QByteArray PdfStripWriter::encodeBand(const QImage& band, ColorModel colorModel)
+{
+    QImage rows;
+    if (colorModel == ColorModel::Cmyk) {
+        if (band.format() != QImage::Format_CMYK8888) return QByteArray();
+        rows = band;
+    } else {
+        rows = band.convertToFormat(QImage::Format_RGB888);
+        if (rows.isNull()) return QByteArray();
+    }
+
+    // PDF图像数据的各行紧密排列，去掉QImage的行尾填充
+    const qsizetype rowBytes = qsizetype(rows.width()) * (colorModel == ColorModel::Cmyk ? 4 : 3);
+    QByteArray packed(rowBytes * rows.height(), Qt::Uninitialized);
+    for (int y = 0; y < rows.height(); ++y) {
+        memcpy(packed.data() + y * rowBytes, rows.constScanLine(y), rowBytes);
+    }
+    return flateEncode(packed.constData(), packed.size());
+}
+
+bool PdfStripWriter::writeEncodedBand(const QByteArray& encodedBand, int rows)
+{
+    if (!file.isOpen()) return fail("PDF文件未打开。");
+    if (encodedBand.isEmpty()) return fail("压缩PDF条带时内存不足或条带格式不匹配。");
+    if (rows <= 0 || rowsWritten + rows > size.height()) return fail("条带尺寸与PDF图像尺寸不匹配。");
+
+    const qint64 offset = file.pos();
+    const QByteArray dictionary = bandDictionary(bandOffsets.size(), rows, encodedBand.size());
+    if (file.write(dictionary) != dictionary.size() || file.write(encodedBand) != encodedBand.size()
+        || file.write(streamEnd) != streamEnd.size()) {
+        return fail(QString("写入PDF数据失败: %1").arg(file.errorString()));
+    }
+    bandOffsets.append(offset);
+    bandRows.append(rows);
+    rowsWritten += rows;
+    return true;
+}
+
+bool PdfStripWriter::writeBand(const QImage& band)
+{
+    if (band.width() != size.width()) return fail("条带尺寸与PDF图像尺寸不匹配。");
+    return writeEncodedBand(encodeBand(band, model), band.height());
+}
+
+bool PdfStripWriter::flush()
+{
+    if (!file.isOpen()) return fail("PDF文件未打开。");
+    if (!file.flush()) return fail(QString("写入PDF数据失败: %1").arg(file.errorString()));
+    return true;
+}
+
+bool PdfStripWriter::close()
+{
+    if (!file.isOpen()) return fail("PDF文件未打开。");
+    if (rowsWritten != size.height()) return fail("PDF数据不完整，无法结束写入。");
+
+    const int bandCount = bandOffsets.size();
+    const int contentsObject = profileObject + 1 + bandCount;
+    const int pageObject = contentsObject + 1;
+    const int pagesObject = pageObject + 1;
+    const int catalogObject = pagesObject + 1;
+
+    // 每个条带按像素位置放到页面上：1像素 = 72/DPI点，PDF坐标原点在左下角
+    const double unit = userUnit();
+    const double pointsPerPixel = 72.0 / resolutionDpi / unit;
+    const QByteArray pageWidth = pdfNumber(size.width() * pointsPerPixel);
+    QByteArray content;
+    QByteArray xObjects;
+    int top = 0;
+    for (int i = 0; i < bandCount; ++i) {
+        const QByteArray name = "/Im" + QByteArray::number(i);
+        content += "q " + pageWidth + " 0 0 " + pdfNumber(bandRows[i] * pointsPerPixel)
+                   + " 0 " + pdfNumber((size.height() - top - bandRows[i]) * pointsPerPixel)
+                   + " cm " + name + " Do Q\n";
+        xObjects += name + " " + QByteArray::number(profileObject + 1 + i) + " 0 R ";
+        top += bandRows[i];
+    }
+    const QByteArray compressedContent = flateEncode(content.constData(), content.size());
+
+    QList<qint64> objectOffsets{file.pos()};
+    QByteArray tail = objectHeader(contentsObject) + "<< /Filter /FlateDecode /Length "
+                      + QByteArray::number(compressedContent.size()) + " >>\nstream\n"
+                      + compressedContent + streamEnd;
+
+    objectOffsets.append(objectOffsets.first() + tail.size());
+    tail += objectHeader(pageObject) + "<< /Type /Page /Parent " + QByteArray::number(pagesObject) + " 0 R"
+            + " /MediaBox [0 0 " + pageWidth + " " + pdfNumber(size.height() * pointsPerPixel) + "]"
+            + (unit > 1.0 ? " /UserUnit " + pdfNumber(unit) : QByteArray())
+            + " /Resources << /XObject << " + xObjects + ">> >>"
+            + " /Contents " + QByteArray::number(contentsObject) + " 0 R >>\nendobj\n";
+
+    objectOffsets.append(objectOffsets.first() + tail.size());
+    tail += objectHeader(pagesObject) + "<< /Type /Pages /Kids [" + QByteArray::number(pageObject) + " 0 R] /Count 1 >>\nendobj\n";
+
+    objectOffsets.append(objectOffsets.first() + tail.size());
+    tail += objectHeader(catalogObject) + "<< /Type /Catalog /Pages " + QByteArray::number(pagesObject) + " 0 R >>\nendobj\n";
+
+    // 交叉引用表：对象0固定为空闲，之后是ICC配置文件、各条带和页面结构，每项正好20字节
+    const qint64 xrefOffset = objectOffsets.first() + tail.size();
+    if (xrefOffset > maxXrefOffset) return fail("PDF文件超过10GB，请改用TIFF格式输出。");
+
+    QList<qint64> allOffsets{fileHeader.size()};
+    allOffsets += bandOffsets;
+    allOffsets += objectOffsets;
+    tail += "xref\n0 " + QByteArray::number(allOffsets.size() + 1) + "\n0000000000 65535 f \n";
+    for (qint64 offset : allOffsets) {
+        tail += QByteArray::number(offset).rightJustified(10, '0') + " 00000 n \n";
+    }
+    tail += "trailer\n<< /Size " + QByteArray::number(allOffsets.size() + 1)
+            + " /Root " + QByteArray::number(catalogObject) + " 0 R >>\nstartxref\n"
+            + QByteArray::number(xrefOffset) + "\n%%EOF\n";
+
+    if (file.write(tail) != tail.size()) {
+        return fail(QString("写入PDF页面结构失败: %1").arg(file.errorString()));
+    }
+
+    file.close();
+    if (file.error() != QFileDevice::NoError) {
+        return fail(QString("关闭PDF文件失败: %1").arg(file.errorString()));
+    }
+    return true;
+}
+
+void PdfStripWriter::abort()
+{
+    if (file.isOpen()) file.close();
+    file.remove();
+}
+
+void PdfStripWriter::suspend()
+{
+    if (file.isOpen()) file.close();
+}
+
+bool PdfStripWriter::fail(const QString& message)
+{
+    lastError = message;
+    return false;
+}
@@ -0,0 +1,116 @@
+#ifndef PDFWRITER_H
+#define PDFWRITER_H
+
+#include <QFile>
+#include <QImage>
+#include <QSize>
+#include <QSizeF>
+#include <QString>
+#include <QByteArray>
+#include <QList>
+
+/**
+ * @class PdfStripWriter
+ * @brief 以条带为单位流式写出单页PDF文件，整幅图像无需同时驻留内存。
+ *
+ * 页面尺寸按像素尺寸和DPI换算，与界面推荐的物理尺寸一致，印刷时无需再缩放。
+ * 每个条带Flate压缩后作为一个图像XObject追加写入文件，在页面上按原位置无缝拼接；
+ * 页面、内容流和交叉引用表在close()时写在数据之后。
+ */
+class PdfStripWriter
+{
+public:
+    /// @brief 输出文件的颜色模型。
+    enum class ColorModel {
+        Rgb,    ///< 8位RGB，接受ARGB32/RGB32条带
+        Cmyk    ///< 8位CMYK(分色)，接受CMYK8888条带
+    };
+
+    PdfStripWriter() = default;
+    ~PdfStripWriter();
+
+    /**
+     * @brief 创建输出文件并写入文件头和ICC配置文件。
+     * @param path 输出文件路径。
+     * @param imageSize 整幅图像的像素尺寸。
+     * @param colorModel 颜色模型。
+     * @param dpi 输出分辨率，决定页面的物理尺寸。
+     * @param iccProfile 图像色彩空间的ICC配置文件，可为空(此时使用设备色彩空间)。
+     */
+    bool open(const QString& path, const QSize& imageSize, ColorModel colorModel, double dpi, const QByteArray& iccProfile = QByteArray());
+
+    /**
+     * @brief 重新打开之前suspend()的未完成文件，从completedRows行之后继续写入。
+     * 参数须与最初open()时一致；completedRows须落在条带边界上，之后的数据会被截掉。
+     */
+    bool resume(const QString& path, const QSize& imageSize, ColorModel colorModel, double dpi,
+                const QByteArray& iccProfile, int completedRows);
+
+    /**
+     * @brief 将一个条带转换并压缩为PDF图像数据，可在任意线程中调用。
+     * @return 压缩后的数据；格式不匹配或内存不足时返回空数组。
+     */
+    static QByteArray encodeBand(const QImage& band, ColorModel colorModel);
+
+    /**
+     * @brief 按顺序追加一个由encodeBand()压缩好的条带。
+     * @param rows 条带的行数。
+     */
+    bool writeEncodedBand(const QByteArray& encodedBand, int rows);
+
+    /**
+     * @brief 按顺序追加一个条带(若干完整的行)。
+     * @param band 宽度必须与图像一致；格式需与颜色模型匹配。
+     */
+    bool writeBand(const QImage& band);
+
+    /**
+     * @brief 将已写入的数据交给操作系统，之后即使程序退出这些行也不会丢失。
+     */
+    bool flush();
+
+    /**
+     * @brief 写入页面、内容流和交叉引用表并关闭文件。所有行都必须已写入。
+     */
+    bool close();
+
+    /**
+     * @brief 放弃写入并删除未完成的文件。
+     */
+    void abort();
+
+    /**
+     * @brief 关闭未完成的文件但保留已写入的数据，以便之后用resume()继续。
+     */
+    void suspend();
+
+    /// @brief 页面的物理尺寸(厘米)。
+    QSizeF pageSizeCm() const;
+
+    QString errorString() const { return lastError; }
+
+private:
+    QFile file;
+    QSize size;
+    ColorModel model = ColorModel::Rgb;
+    double resolutionDpi = 0.0;
+    QByteArray embeddedProfile;
+    int rowsWritten = 0;
+    QList<qint64> bandOffsets;      ///< 各条带对象在文件中的偏移
+    QList<int> bandRows;            ///< 各条带的行数
+    QString lastError;
+
+    /// @brief 单个PDF页面边长的上限(点)。超过时用UserUnit放大页面单位。
+    static constexpr double maxPageExtent = 14400.0;
+
+    /// @brief ICC配置文件的对象号，条带对象从下一个编号开始。
+    static constexpr int profileObject = 1;
+
+    bool fail(const QString& message);
+    void prepare(const QSize& imageSize, ColorModel colorModel, double dpi, const QByteArray& iccProfile);
+    QByteArray buildPreamble() const;
+    QByteArray bandDictionary(int bandIndex, int rows, qint64 length) const;
+    double userUnit() const;
+};
+
+#endif // PDFWRITER_H
@@ -0,0 +1,200 @@
+#include "renderjournal.h"
+
+#include <QDir>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QStandardPaths>
+#include <QCryptographicHash>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QDebug>
+#include <stdexcept>
+
+namespace {
+
+const char* const jobFileName = "job.json";
+const char* const journalFileName = "journal.log";
+const char* const lockFileName = "job.lock";
+
+/**
+ * @brief 源文件的大小和修改时间，源文件被修改后旧的检查点自然失效。
+ */
+void addSourceStates(QCryptographicHash& hash, const QList<QString>& imagePaths)
+{
+    for (const QString& path : imagePaths) {
+        const QFileInfo info(path);
+        hash.addData(QString("%1|%2\n").arg(info.size()).arg(info.lastModified().toMSecsSinceEpoch()).toUtf8());
+    }
+}
+
+} // namespace
+
+RenderJournal::RenderJournal(const RenderSettings& settings)
+    : settings(settings)
+{}
+
+RenderJournal::~RenderJournal()
+{
+    if (journalFile.isOpen()) journalFile.close();
+}
+
+QString RenderJournal::rootPath()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation) + "/renders";
+}
+
+QString RenderJournal::jobKey(const RenderSettings& settings)
+{
+    // 全部参数都参与哈希，之后加入的参数无需登记即可使旧的检查点失效。只有内存分配方式不影响输出，切换后仍可续接
+    QJsonObject json = renderSettingsToJson(settings);
+    json.remove("largePageBuffers");
+
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(QJsonDocument(json).toJson(QJsonDocument::Compact));
+    addSourceStates(hash, settings.imagePaths);
+    return QString::fromLatin1(hash.result().toHex());
+}
+
+void RenderJournal::open()
+{
+    const int targetCount = settings.targets.size();
+    rowsPerTarget = QList<int>(targetCount, 0);
+    savedTargets = QList<bool>(targetCount, false);
+    completedFrames.clear();
+
+    workDir = rootPath() + "/" + jobKey(settings);
+    if (!QDir().mkpath(workDir)) throw std::runtime_error("无法创建渲染任务的工作目录。");
+
+    lock = std::make_unique<QLockFile>(workDir + "/" + lockFileName);
+    if (!lock->tryLock(0)) throw std::runtime_error("相同的渲染任务正在进行中。");
+
+    // 读取已有的日志。最后一行可能因程序中途退出而不完整，无法解析的记录直接忽略
+    journalFile.setFileName(workDir + "/" + journalFileName);
+    resumed = journalFile.exists();
+    if (resumed && journalFile.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        while (!journalFile.atEnd()) {
+            const QStringList fields = QString::fromUtf8(journalFile.readLine()).trimmed().split(' ');
+            if (fields.size() < 2) continue;
+            bool ok = false;
+            const int target = fields[1].toInt(&ok);
+            if (!ok || target < 0 || target >= targetCount) continue;
+
+            if (fields[0] == "frame" && fields.size() == 3) {
+                completedFrames.insert(fields[1] + "/" + fields[2]);
+            } else if (fields[0] == "rows" && fields.size() == 3) {
+                rowsPerTarget[target] = qMax(rowsPerTarget[target], fields[2].toInt());
+            } else if (fields[0] == "saved") {
+                savedTargets[target] = true;
+            }
+        }
+        journalFile.close();
+    }
+
+    // 保存任务参数，程序重启后可据此列出并续接未完成的任务
+    QFile jobFile(workDir + "/" + jobFileName);
+    if (!jobFile.exists()) {
+        if (!jobFile.open(QIODevice::WriteOnly) || jobFile.write(QJsonDocument(renderSettingsToJson(settings)).toJson()) < 0) {
+            throw std::runtime_error("无法写入渲染任务信息，请检查磁盘空间。");
+        }
+        jobFile.close();
+    }
+
+    if (!journalFile.open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Text)) {
+        throw std::runtime_error("无法打开渲染日志文件。");
+    }
+    if (resumed) qDebug() << "从检查点续接渲染任务:" << workDir;
+}
+
+bool RenderJournal::hasFrame(int target, int frame) const
+{
+    return completedFrames.contains(QString("%1/%2").arg(target).arg(frame));
+}
+
+void RenderJournal::markFrame(int target, int frame)
+{
+    completedFrames.insert(QString("%1/%2").arg(target).arg(frame));
+    append(QString("frame %1 %2").arg(target).arg(frame));
+}
+
+int RenderJournal::completedRows(int target) const
+{
+    return rowsPerTarget.value(target, 0);
+}
+
+void RenderJournal::markRows(int target, int rows)
+{
+    rowsPerTarget[target] = rows;
+    append(QString("rows %1 %2").arg(target).arg(rows));
+}
+
+bool RenderJournal::isSaved(int target) const
+{
+    return savedTargets.value(target, false);
+}
+
+void RenderJournal::markSaved(int target)
+{
+    savedTargets[target] = true;
+    append(QString("saved %1").arg(target));
+}
+
+void RenderJournal::append(const QString& record)
+{
+    const QByteArray line = (record + "\n").toUtf8();
+    if (journalFile.write(line) != line.size() || !journalFile.flush()) {
+        throw std::runtime_error("写入渲染日志失败，请检查磁盘空间。");
+    }
+}
+
+void RenderJournal::finish()
+{
+    journalFile.close();
+    lock.reset();
+    QDir(workDir).removeRecursively();
+}
+
+QList<RenderJournal::PendingJob> RenderJournal::pendingJobs()
+{
+    QList<PendingJob> jobs;
+    const QDir root(rootPath());
+    for (const QString& key : root.entryList(QDir::Dirs | QDir::NoDotAndDotDot)) {
+        const QString dirPath = root.filePath(key);
+
+        // 正在被其他窗口或进程渲染的任务不列出
+        QLockFile dirLock(dirPath + "/" + lockFileName);
+        if (!dirLock.tryLock(0)) continue;
+        dirLock.unlock();
+
+        QFile jobFile(dirPath + "/" + jobFileName);
+        QJsonObject storedJson;
+        if (jobFile.open(QIODevice::ReadOnly)) {
+            storedJson = QJsonDocument::fromJson(jobFile.readAll()).object();
+            jobFile.close();
+        }
+
+        // 没有有效任务信息的目录无从续接，也不知道输出文件在哪里，只清理目录本身
+        PendingJob job;
+        job.settings = renderSettingsFromJson(storedJson);
+        if (job.settings.imagePaths.isEmpty() || job.settings.targets.isEmpty()) {
+            qDebug() << "清理没有任务信息的工作目录:" << dirPath;
+            QDir(dirPath).removeRecursively();
+            continue;
+        }
+
+        job.workDir = dirPath;
+        job.resumable = jobKey(job.settings) == key;
+        if (!job.resumable) qDebug() << "渲染任务的源文件已变化，无法续接:" << dirPath;
+        jobs.append(job);
+    }
+    return jobs;
+}
+
+void RenderJournal::discard(const PendingJob& job, bool removePartialOutputs)
+{
+    if (removePartialOutputs) {
+        for (const RenderTarget& target : job.settings.targets) {
+            QFile::remove(partialOutputPath(target.savePath));
+        }
+    }
+    QDir(job.workDir).removeRecursively();
+}
@@ -0,0 +1,96 @@
+#ifndef RENDERJOURNAL_H
+#define RENDERJOURNAL_H
+
+#include "lenticularrenderer.h"
+
+#include <QList>
+#include <QSet>
+#include <QString>
+#include <QFile>
+#include <QLockFile>
+#include <memory>
+
+/**
+ * @class RenderJournal
+ * @brief 最终渲染的检查点日志，使中断的任务可以从上次的进度继续。
+ *
+ * 每个任务在持久的工作目录中保存阶段一的缩放帧、阶段二已合成的行以及一份追加写入的日志。
+ * 工作目录以任务参数和源文件状态的哈希命名，参数相同的任务再次运行时自动续接；
+ * 任务全部完成后工作目录被删除。日志只追加、每条记录立即刷新，程序在任意时刻退出都不会破坏已有的检查点。
+ */
+class RenderJournal
+{
+public:
+    explicit RenderJournal(const RenderSettings& settings);
+    ~RenderJournal();
+
+    /**
+     * @brief 创建或打开任务的工作目录，并读取已有的检查点。出错时抛出std::exception。
+     */
+    void open();
+
+    /// @brief 任务的工作目录，临时文件都存放在这里。
+    QString workDirPath() const { return workDir; }
+
+    /// @brief 是否从已有的检查点续接。
+    bool isResumed() const { return resumed; }
+
+    /// @brief 某个目标的某一帧是否已完成缩放并写入工作目录。
+    bool hasFrame(int target, int frame) const;
+    void markFrame(int target, int frame);
+
+    /// @brief 某个目标已合成并写出的行数，阶段二从这一行继续。
+    int completedRows(int target) const;
+    void markRows(int target, int rows);
+
+    /// @brief 某个目标的最终文件是否已保存。
+    bool isSaved(int target) const;
+    void markSaved(int target);
+
+    /// @brief 任务全部完成，删除工作目录。
+    void finish();
+
+    /// @brief TIFF输出在完成前写入的未完成文件路径，全部完成后改名为保存路径。
+    static QString partialOutputPath(const QString& savePath) { return savePath + ".part"; }
+
+    /// @brief 所有任务工作目录所在的根目录。
+    static QString rootPath();
+
+    /**
+     * @brief 由任务参数和源文件的大小、修改时间计算任务标识。不影响输出的内存分配方式不参与。
+     */
+    static QString jobKey(const RenderSettings& settings);
+
+    /// @brief 一个未完成任务的工作目录及其参数。
+    struct PendingJob {
+        RenderSettings settings;
+        QString workDir;
+        bool resumable = false;     ///< 源文件在中断后被修改过的任务无法续接，但已写出的数据仍然保留
+    };
+
+    /**
+     * @brief 列出所有未完成的任务。源文件在中断后被修改过的任务标记为无法续接。
+     * 不会删除任何未完成的输出文件；只有没有有效任务信息的目录会被清理。
+     */
+    static QList<PendingJob> pendingJobs();
+
+    /**
+     * @brief 放弃一个未完成的任务，删除其工作目录。
+     * @param removePartialOutputs 是否同时删除未完成的输出文件。
+     */
+    static void discard(const PendingJob& job, bool removePartialOutputs);
+
+private:
+    RenderSettings settings;
+    QString workDir;
+    bool resumed = false;
+    std::unique_ptr<QLockFile> lock;    // 防止同一任务被同时渲染
+    QFile journalFile;
+    QSet<QString> completedFrames;      // "target/frame"
+    QList<int> rowsPerTarget;
+    QList<bool> savedTargets;
+
+    void append(const QString& record);
+};
+
+#endif // RENDERJOURNAL_H
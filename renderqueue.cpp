@@ -0,0 +1,199 @@
+#include "renderqueue.h"
+
+#include <QThread>
+#include <QMetaObject>
+#include <stdexcept>
+
+namespace {
+
+/// @brief 估计剩余时间所用的进度采样窗口
+constexpr qint64 etaWindowMs = 20000;
+
+} // namespace
+
+RenderQueue::RenderQueue(QObject* parent)
+    : QObject(parent)
+{}
+
+RenderQueue::~RenderQueue()
+{
+    cancelAll();
+    waitForCurrentJob();
+    delete workerThread;
+}
+
+int RenderQueue::enqueue(const RenderSettings& settings, const QString& description)
+{
+    RenderJob job;
+    job.id = nextJobId++;
+    job.description = description;
+    job.settings = settings;
+    job.stage = "排队中";
+    jobList.append(job);
+    waitingJobs.enqueue(job.id);
+    emit jobAdded(job.id);
+
+    if (!workerThread) startNextJob();
+    return job.id;
+}
+
+void RenderQueue::cancel(int jobId)
+{
+    if (jobId == currentJobId) {
+        cancelRequested = true;
+        return;
+    }
+
+    RenderJob* job = findJob(jobId);
+    if (!job || job->state != RenderJobState::Queued) return;
+    waitingJobs.removeAll(jobId);
+    job->state = RenderJobState::Canceled;
+    job->stage = "已取消";
+    emit jobChanged(jobId);
+    emit jobFinished(jobId, RenderJobState::Canceled, QString());
+}
+
+void RenderQueue::cancelAll()
+{
+    while (!waitingJobs.isEmpty()) cancel(waitingJobs.head());
+    if (currentJobId != 0) cancel(currentJobId);
+}
+
+void RenderQueue::waitForCurrentJob()
+{
+    if (workerThread) workerThread->wait();
+}
+
+void RenderQueue::clearFinished()
+{
+    for (qsizetype i = jobList.size() - 1; i >= 0; --i) {
+        const RenderJobState state = jobList[i].state;
+        if (state != RenderJobState::Queued && state != RenderJobState::Running) jobList.removeAt(i);
+    }
+    emit jobsCleared();
+}
+
+bool RenderQueue::isBusy() const
+{
+    return currentJobId != 0 || !waitingJobs.isEmpty();
+}
+
+RenderJob RenderQueue::job(int jobId) const
+{
+    for (const RenderJob& job : jobList) {
+        if (job.id == jobId) return job;
+    }
+    return RenderJob();
+}
+
+RenderJob* RenderQueue::findJob(int jobId)
+{
+    for (RenderJob& job : jobList) {
+        if (job.id == jobId) return &job;
+    }
+    return nullptr;
+}
+
+void RenderQueue::startNextJob()
+{
+    if (waitingJobs.isEmpty()) return;
+
+    const int jobId = waitingJobs.dequeue();
+    RenderJob* job = findJob(jobId);
+    if (!job) return;
+
+    currentJobId = jobId;
+    cancelRequested = false;
+    job->state = RenderJobState::Running;
+    job->stage = "正在准备...";
+    jobTimer.start();
+    progressSamples.clear();
+    emit jobChanged(jobId);
+
+    // 渲染器在独立线程中运行，不占用全局线程池中负责合成条带的线程
+    const RenderSettings settings = job->settings;
+    FrameCache* cache = frameCache;
+    workerThread = QThread::create([this, jobId, settings, cache]() {
+        int lastPercent = -1;
+        QString lastStage;
+        auto progress = [&](int percent, const QString& stage) {
+            // 只在进度或阶段变化时通知主线程，渲染循环中只剩一次原子读取
+            if (percent != lastPercent || stage != lastStage) {
+                lastPercent = percent;
+                lastStage = stage;
+                QMetaObject::invokeMethod(this, [this, jobId, percent, stage]() {
+                    updateProgress(jobId, percent, stage);
+                }, Qt::QueuedConnection);
+            }
+            return !cancelRequested.load();
+        };
+
+        RenderJobState state = RenderJobState::Failed;
+        QString message;
+        try {
+            LenticularRenderer renderer(settings);
+            renderer.setFrameCache(cache);
+            state = renderer.run(progress) ? RenderJobState::Finished : RenderJobState::Canceled;
+        } catch (const std::exception& e) {
+            message = QString::fromUtf8(e.what());
+        }
+
+        QMetaObject::invokeMethod(this, [this, state, message]() {
+            finishCurrentJob(state, message);
+        }, Qt::QueuedConnection);
+    });
+    workerThread->start();
+}
+
+void RenderQueue::updateProgress(int jobId, int percent, const QString& stage)
+{
+    RenderJob* job = findJob(jobId);
+    if (!job || job->state != RenderJobState::Running) return;
+
+    job->percent = percent;
+    job->stage = stage;
+    job->etaSeconds = estimateRemainingSeconds(percent);
+    emit jobChanged(jobId);
+}
+
+int RenderQueue::estimateRemainingSeconds(int percent)
+{
+    const qint64 now = jobTimer.elapsed();
+    progressSamples.append(qMakePair(now, percent));
+    while (progressSamples.size() > 2 && now - progressSamples.first().first > etaWindowMs) {
+        progressSamples.removeFirst();
+    }
+
+    // 续接的任务会快速跳过已完成的部分，因此只看最近窗口内的速率，而不是从任务开始的平均速率
+    const qint64 elapsedMs = now - progressSamples.first().first;
+    const int progressed = percent - progressSamples.first().second;
+    if (elapsedMs < 1000 || progressed <= 0) return -1;
+    return static_cast<int>((100 - percent) * elapsedMs / progressed / 1000);
+}
+
+void RenderQueue::finishCurrentJob(RenderJobState state, const QString& message)
+{
+    const int jobId = currentJobId;
+    if (workerThread) {
+        workerThread->wait();
+        workerThread->deleteLater();
+        workerThread = nullptr;
+    }
+    currentJobId = 0;
+
+    if (RenderJob* job = findJob(jobId)) {
+        job->state = state;
+        job->message = message;
+        job->etaSeconds = -1;
+        if (state == RenderJobState::Finished) {
+            job->percent = 100;
+            job->stage = "已完成";
+        } else {
+            job->stage = (state == RenderJobState::Canceled) ? "已取消" : "出错";
+        }
+        emit jobChanged(jobId);
+    }
+    emit jobFinished(jobId, state, message);
+
+    startNextJob();
+}
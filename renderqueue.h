@@ -0,0 +1,124 @@
+#ifndef RENDERQUEUE_H
+#define RENDERQUEUE_H
+
+#include "lenticularrenderer.h"
+
+#include <QObject>
+#include <QList>
+#include <QQueue>
+#include <QPair>
+#include <QString>
+#include <QElapsedTimer>
+#include <atomic>
+
+class QThread;
+class FrameCache;
+
+/// @brief 渲染任务的状态。
+enum class RenderJobState {
+    Queued,     ///< 排队等待
+    Running,    ///< 正在渲染
+    Finished,   ///< 已完成
+    Canceled,   ///< 已取消，进度已保存在检查点中
+    Failed      ///< 出错，进度已保存在检查点中
+};
+
+/**
+ * @struct RenderJob
+ * @brief 队列中的一个最终渲染任务。
+ */
+struct RenderJob {
+    int id = 0;
+    QString description;            ///< 在任务面板中显示的描述
+    RenderSettings settings;
+    RenderJobState state = RenderJobState::Queued;
+    int percent = 0;
+    QString stage;                  ///< 当前阶段描述
+    int etaSeconds = -1;            ///< 预计剩余秒数，-1表示尚无法估计
+    QString message;                ///< 完成或出错时的说明
+};
+
+/**
+ * @class RenderQueue
+ * @brief 最终渲染的任务队列：任务按提交顺序在后台线程中逐个执行，界面始终保持可操作。
+ *
+ * 渲染线程只负责执行LenticularRenderer并转发进度，任务状态只在主线程中修改，
+ * 所有信号都在主线程中发出。取消通过进度回调返回false实现，渲染器在下一个条带处停止并保留检查点。
+ */
+class RenderQueue : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit RenderQueue(QObject* parent = nullptr);
+
+    /**
+     * @brief 析构时取消所有任务并等待渲染线程结束。
+     */
+    ~RenderQueue() override;
+
+    /**
+     * @brief 将任务加入队列末尾，空闲时立即开始。
+     * @return 任务编号。
+     */
+    int enqueue(const RenderSettings& settings, const QString& description);
+
+    /**
+     * @brief 取消任务：排队中的任务直接移出队列，正在渲染的任务在下一个条带处停止。
+     */
+    void cancel(int jobId);
+
+    /// @brief 取消所有排队和正在进行的任务。
+    void cancelAll();
+
+    /// @brief 阻塞等待正在渲染的任务结束，用于程序退出前。
+    void waitForCurrentJob();
+
+    /// @brief 移除已结束(完成、取消或出错)的任务记录。
+    void clearFinished();
+
+    /// @brief 是否有任务正在渲染或排队。
+    bool isBusy() const;
+
+    /**
+     * @brief 设置之后的任务共享的帧缓存，缓存由调用者持有。
+     */
+    void setFrameCache(FrameCache* cache) { frameCache = cache; }
+
+    QList<RenderJob> jobs() const { return jobList; }
+    RenderJob job(int jobId) const;
+
+signals:
+    /// @brief 新任务加入队列。
+    void jobAdded(int jobId);
+
+    /// @brief 任务的状态、进度或预计剩余时间发生变化。
+    void jobChanged(int jobId);
+
+    /// @brief 任务结束。state为Finished、Canceled或Failed。
+    void jobFinished(int jobId, RenderJobState state, const QString& message);
+
+    /// @brief 已结束的任务记录被移除。
+    void jobsCleared();
+
+private:
+    QList<RenderJob> jobList;
+    QQueue<int> waitingJobs;
+    int nextJobId = 1;
+    int currentJobId = 0;
+    QThread* workerThread = nullptr;
+    std::atomic<bool> cancelRequested{false};
+    FrameCache* frameCache = nullptr;
+
+    // 预计剩余时间：按最近一段时间内实测的进度速率推算
+    QElapsedTimer jobTimer;
+    QList<QPair<qint64, int>> progressSamples;  ///< (毫秒, 百分比)
+
+    RenderJob* findJob(int jobId);
+    void startNextJob();
+    void updateProgress(int jobId, int percent, const QString& stage);
+    void finishCurrentJob(RenderJobState state, const QString& message);
+    int estimateRemainingSeconds(int percent);
+};
+
+#endif // RENDERQUEUE_H
@@ -0,0 +1,126 @@
+#include "renderqueuepanel.h"
+
+#include <QListWidget>
+#include <QLabel>
+#include <QProgressBar>
+#include <QPushButton>
+
+RenderQueuePanel::RenderQueuePanel(RenderQueue* queue, QWidget* parent)
+    : QWidget(parent, Qt::Tool)
+    , renderQueue(queue)
+{
+    setWindowTitle("渲染任务");
+    setFixedSize(480, 320);
+
+    jobListWidget = new QListWidget(this);
+    jobListWidget->setGeometry(10, 10, 460, 200);
+    jobListWidget->setSelectionMode(QAbstractItemView::ExtendedSelection);
+
+    stageLabel = new QLabel("没有正在进行的任务。", this);
+    stageLabel->setGeometry(10, 215, 460, 22);
+
+    progressBar = new QProgressBar(this);
+    progressBar->setGeometry(10, 240, 460, 22);
+    progressBar->setRange(0, 100);
+    progressBar->setValue(0);
+
+    cancelButton = new QPushButton("取消所选", this);
+    cancelButton->setGeometry(10, 280, 140, 30);
+    cancelButton->setToolTip("排队中的任务直接移出队列；正在渲染的任务会停止，已完成的进度保留，可稍后继续。");
+
+    clearButton = new QPushButton("清除已结束", this);
+    clearButton->setGeometry(160, 280, 140, 30);
+
+    closeButton = new QPushButton("隐藏", this);
+    closeButton->setGeometry(370, 280, 100, 30);
+    closeButton->setToolTip("隐藏面板，任务在后台继续进行。");
+
+    connect(renderQueue, &RenderQueue::jobAdded, this, &RenderQueuePanel::rebuildJobList);
+    connect(renderQueue, &RenderQueue::jobsCleared, this, &RenderQueuePanel::rebuildJobList);
+    connect(renderQueue, &RenderQueue::jobChanged, this, &RenderQueuePanel::refreshJob);
+    connect(jobListWidget, &QListWidget::itemSelectionChanged, this, &RenderQueuePanel::updateButtonStates);
+    connect(cancelButton, &QPushButton::clicked, this, &RenderQueuePanel::cancelSelectedJobs);
+    connect(clearButton, &QPushButton::clicked, renderQueue, &RenderQueue::clearFinished);
+    connect(closeButton, &QPushButton::clicked, this, &QWidget::hide);
+
+    rebuildJobList();
+}
+
+void RenderQueuePanel::rebuildJobList()
+{
+    jobListWidget->clear();
+    for (const RenderJob& job : renderQueue->jobs()) {
+        QListWidgetItem* item = new QListWidgetItem(jobText(job));
+        item->setData(Qt::UserRole, job.id);
+        item->setToolTip(job.message.isEmpty() ? job.description : job.message);
+        jobListWidget->addItem(item);
+        if (job.state == RenderJobState::Running) refreshJob(job.id);
+    }
+    updateButtonStates();
+}
+
+void RenderQueuePanel::refreshJob(int jobId)
+{
+    const RenderJob job = renderQueue->job(jobId);
+    if (QListWidgetItem* item = findItem(jobId)) {
+        item->setText(jobText(job));
+        item->setToolTip(job.message.isEmpty() ? job.description : job.message);
+    }
+
+    // 进度条只跟随正在渲染的任务，任务结束后显示其最终状态
+    if (job.state == RenderJobState::Queued) return;
+    progressBar->setValue(job.percent);
+    if (job.state == RenderJobState::Running) {
+        QString text = job.stage;
+        if (job.etaSeconds >= 0) text += QString("  预计剩余%1").arg(formatRemainingTime(job.etaSeconds));
+        stageLabel->setText(text);
+    } else {
+        stageLabel->setText(QString("%1: %2").arg(job.description, job.stage));
+    }
+    updateButtonStates();
+}
+
+void RenderQueuePanel::cancelSelectedJobs()
+{
+    for (QListWidgetItem* item : jobListWidget->selectedItems()) {
+        renderQueue->cancel(item->data(Qt::UserRole).toInt());
+    }
+}
+
+void RenderQueuePanel::updateButtonStates()
+{
+    bool canCancel = false;
+    for (QListWidgetItem* item : jobListWidget->selectedItems()) {
+        const RenderJobState state = renderQueue->job(item->data(Qt::UserRole).toInt()).state;
+        if (state == RenderJobState::Queued || state == RenderJobState::Running) canCancel = true;
+    }
+    cancelButton->setEnabled(canCancel);
+}
+
+QListWidgetItem* RenderQueuePanel::findItem(int jobId) const
+{
+    for (int i = 0; i < jobListWidget->count(); ++i) {
+        if (jobListWidget->item(i)->data(Qt::UserRole).toInt() == jobId) return jobListWidget->item(i);
+    }
+    return nullptr;
+}
+
+QString RenderQueuePanel::jobText(const RenderJob& job)
+{
+    QString state;
+    switch (job.state) {
+    case RenderJobState::Queued:   state = "排队中"; break;
+    case RenderJobState::Running:  state = QString("%1%").arg(job.percent); break;
+    case RenderJobState::Finished: state = "已完成"; break;
+    case RenderJobState::Canceled: state = "已取消"; break;
+    case RenderJobState::Failed:   state = "出错"; break;
+    }
+    return QString("#%1  %2  —  %3").arg(job.id).arg(job.description, state);
+}
+
+QString RenderQueuePanel::formatRemainingTime(int seconds)
+{
+    if (seconds < 60) return QString("%1秒").arg(seconds);
+    if (seconds < 3600) return QString("%1分%2秒").arg(seconds / 60).arg(seconds % 60);
+    return QString("%1小时%2分").arg(seconds / 3600).arg((seconds % 3600) / 60);
+}
@@ -0,0 +1,53 @@
+#ifndef RENDERQUEUEPANEL_H
+#define RENDERQUEUEPANEL_H
+
+#include "renderqueue.h"
+
+#include <QWidget>
+
+class QListWidget;
+class QListWidgetItem;
+class QLabel;
+class QProgressBar;
+class QPushButton;
+
+/**
+ * @class RenderQueuePanel
+ * @brief 渲染任务面板：非模态窗口，显示队列中各任务的状态、当前任务的进度和预计剩余时间。
+ */
+class RenderQueuePanel : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit RenderQueuePanel(RenderQueue* queue, QWidget* parent = nullptr);
+
+private slots:
+    /// @brief 任务加入队列或被清除后，重建任务列表。
+    void rebuildJobList();
+
+    /// @brief 更新单个任务的列表项，以及当前任务的进度条。
+    void refreshJob(int jobId);
+
+    /// @brief 响应“取消所选”按钮点击。
+    void cancelSelectedJobs();
+
+    /// @brief 选中项变化时更新按钮状态。
+    void updateButtonStates();
+
+private:
+    RenderQueue* renderQueue;
+
+    QListWidget* jobListWidget;
+    QLabel* stageLabel;
+    QProgressBar* progressBar;
+    QPushButton* cancelButton;
+    QPushButton* clearButton;
+    QPushButton* closeButton;
+
+    QListWidgetItem* findItem(int jobId) const;
+    static QString jobText(const RenderJob& job);
+    static QString formatRemainingTime(int seconds);
+};
+
+#endif // RENDERQUEUEPANEL_H
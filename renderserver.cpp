@@ -0,0 +1,183 @@
+#include "renderserver.h"
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QCommandLineOption>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QJsonDocument>
+#include <QJsonParseError>
+#include <QThreadPool>
+#include <QTimer>
+#include <QDebug>
+
+const char* const RenderServer::defaultServerName = "GratingMagicRender";
+
+namespace {
+
+/// @brief 默认的帧缓存容量(MB)
+constexpr int defaultCacheMb = 2048;
+
+QString jobStateName(RenderJobState state)
+{
+    switch (state) {
+    case RenderJobState::Finished: return "finished";
+    case RenderJobState::Canceled: return "canceled";
+    default: return "failed";
+    }
+}
+
+} // namespace
+
+RenderServer::RenderServer(int cacheMb, QObject* parent)
+    : QObject(parent)
+    , server(new QLocalServer(this))
+    , renderQueue(new RenderQueue(this))
+    , frameCache(cacheMb)
+{
+    // 线程池中的线程常驻，任务之间不再重新创建
+    QThreadPool::globalInstance()->setExpiryTimeout(-1);
+    renderQueue->setFrameCache(&frameCache);
+
+    connect(server, &QLocalServer::newConnection, this, &RenderServer::acceptConnections);
+    connect(renderQueue, &RenderQueue::jobChanged, this, &RenderServer::onJobChanged);
+    connect(renderQueue, &RenderQueue::jobFinished, this, &RenderServer::onJobFinished);
+}
+
+RenderServer::~RenderServer()
+{
+    // 渲染线程可能仍在使用帧缓存，必须在缓存销毁之前结束
+    renderQueue->cancelAll();
+    renderQueue->waitForCurrentJob();
+}
+
+bool RenderServer::listen(const QString& name)
+{
+    // 能连上说明同名服务正在运行；否则清除上次异常退出留下的套接字文件
+    QLocalSocket probe;
+    probe.connectToServer(name);
+    if (probe.waitForConnected(500)) {
+        lastError = "同名的渲染服务已在运行。";
+        return false;
+    }
+    QLocalServer::removeServer(name);
+
+    // 任务里带有任意输入和输出路径，只允许当前用户连接
+    server->setSocketOptions(QLocalServer::UserAccessOption);
+    if (!server->listen(name)) {
+        lastError = server->errorString();
+        return false;
+    }
+    return true;
+}
+
+int RenderServer::exec(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+    qputenv("QT_IMAGEIO_MAXALLOC", "0");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("GratingMagic 渲染服务");
+    parser.addHelpOption();
+    const QCommandLineOption serverOption("server", "以无界面的渲染服务方式运行。");
+    const QCommandLineOption nameOption("name", "本地套接字名称。", "name", defaultServerName);
+    const QCommandLineOption cacheOption("cache-mb", "帧缓存容量(MB)。", "mb", QString::number(defaultCacheMb));
+    parser.addOption(serverOption);
+    parser.addOption(nameOption);
+    parser.addOption(cacheOption);
+    parser.process(app);
+
+    bool ok = false;
+    const int cacheMb = parser.value(cacheOption).toInt(&ok);
+    RenderServer renderServer(ok ? cacheMb : defaultCacheMb);
+    if (!renderServer.listen(parser.value(nameOption))) {
+        qCritical() << "无法启动渲染服务:" << renderServer.errorString();
+        return 1;
+    }
+    qInfo() << "渲染服务已启动:" << parser.value(nameOption);
+    return app.exec();
+}
+
+void RenderServer::acceptConnections()
+{
+    while (server->hasPendingConnections()) {
+        QLocalSocket* socket = server->nextPendingConnection();
+        connect(socket, &QLocalSocket::readyRead, this, [this, socket]() { readRequests(socket); });
+        connect(socket, &QLocalSocket::disconnected, this, [this, socket]() {
+            cancelJobsOf(socket);
+            socket->deleteLater();
+        });
+    }
+}
+
+void RenderServer::readRequests(QLocalSocket* socket)
+{
+    while (socket->canReadLine()) {
+        const QByteArray line = socket->readLine().trimmed();
+        if (line.isEmpty()) continue;
+
+        QJsonParseError parseError;
+        const QJsonDocument document = QJsonDocument::fromJson(line, &parseError);
+        if (!document.isObject()) {
+            sendMessage(socket, QJsonObject{{"type", "error"}, {"message", "无法解析请求：" + parseError.errorString()}});
+            continue;
+        }
+        handleRequest(socket, document.object());
+    }
+}
+
+void RenderServer::handleRequest(QLocalSocket* socket, const QJsonObject& request)
+{
+    const QString type = request["type"].toString();
+    if (type == "render") {
+        const RenderSettings settings = renderSettingsFromJson(request["job"].toObject());
+        if (settings.imagePaths.isEmpty() || settings.targets.isEmpty()) {
+            sendMessage(socket, QJsonObject{{"type", "error"}, {"message", "任务中没有源图像或输出目标。"}});
+            return;
+        }
+
+        const int jobId = renderQueue->enqueue(settings, settings.targets.first().savePath);
+        jobClients.insert(jobId, socket);
+        QJsonObject reply{{"type", "accepted"}, {"id", jobId}};
+        if (request.contains("tag")) reply["tag"] = request["tag"];
+        sendMessage(socket, reply);
+    } else if (type == "cancel") {
+        const int jobId = request["id"].toInt();
+        // 只能取消自己提交的任务
+        if (jobClients.value(jobId) == socket) renderQueue->cancel(jobId);
+    } else {
+        sendMessage(socket, QJsonObject{{"type", "error"}, {"message", "未知的请求类型：" + type}});
+    }
+}
+
+void RenderServer::cancelJobsOf(QLocalSocket* socket)
+{
+    // 取消排队中的任务会立即发出jobFinished并修改jobClients，因此先收集编号
+    QList<int> jobIds;
+    for (auto it = jobClients.cbegin(); it != jobClients.cend(); ++it) {
+        if (it.value() == socket) jobIds.append(it.key());
+    }
+    for (int jobId : jobIds) renderQueue->cancel(jobId);
+}
+
+void RenderServer::onJobChanged(int jobId)
+{
+    const RenderJob job = renderQueue->job(jobId);
+    if (job.state != RenderJobState::Running) return;
+    sendMessage(jobClients.value(jobId), QJsonObject{{"type", "progress"}, {"id", jobId},
+                                                     {"percent", job.percent}, {"stage", job.stage}});
+}
+
+void RenderServer::onJobFinished(int jobId, RenderJobState state, const QString& message)
+{
+    sendMessage(jobClients.take(jobId), QJsonObject{{"type", "finished"}, {"id", jobId},
+                                                    {"state", jobStateName(state)}, {"message", message}});
+    // 服务长期运行，已结束的任务记录不再保留
+    QTimer::singleShot(0, renderQueue, &RenderQueue::clearFinished);
+}
+
+void RenderServer::sendMessage(QLocalSocket* socket, const QJsonObject& message)
+{
+    if (!socket || socket->state() != QLocalSocket::ConnectedState) return;
+    socket->write(QJsonDocument(message).toJson(QJsonDocument::Compact) + '\n');
+}
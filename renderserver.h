@@ -0,0 +1,71 @@
+#ifndef RENDERSERVER_H
+#define RENDERSERVER_H
+
+#include "renderqueue.h"
+#include "framecache.h"
+
+#include <QObject>
+#include <QHash>
+#include <QPointer>
+#include <QString>
+#include <QJsonObject>
+
+class QLocalServer;
+class QLocalSocket;
+
+/**
+ * @class RenderServer
+ * @brief 无界面的常驻渲染服务：通过本地套接字接收渲染任务，并把进度实时发回客户端。
+ *
+ * 进程、线程池和帧缓存在任务之间保留，同一组源图像的多次渲染不再重复启动、解码和缩放。
+ * 任务按提交顺序由RenderQueue逐个执行。协议为每行一个UTF-8编码的JSON对象：
+ *  - 客户端发送 {"type":"render","job":{渲染参数},"tag":任意} 或 {"type":"cancel","id":任务编号}；
+ *  - 服务回复 {"type":"accepted","id":n,"tag":...}、{"type":"progress","id":n,"percent":p,"stage":"..."}、
+ *    {"type":"finished","id":n,"state":"finished|canceled|failed","message":"..."} 或 {"type":"error","message":"..."}。
+ * 渲染参数的格式与renderSettingsToJson()相同。客户端断开时，它提交的任务被取消。
+ */
+class RenderServer : public QObject
+{
+    Q_OBJECT
+
+public:
+    /// @brief 默认的本地套接字名称。
+    static const char* const defaultServerName;
+
+    /**
+     * @param cacheMb 帧缓存容量(MB)。
+     */
+    explicit RenderServer(int cacheMb, QObject* parent = nullptr);
+    ~RenderServer() override;
+
+    /**
+     * @brief 开始监听。同名服务已在运行时失败。
+     */
+    bool listen(const QString& name);
+
+    QString errorString() const { return lastError; }
+
+    /**
+     * @brief 以 --server 参数启动时的入口：解析命令行，运行服务直到进程结束。
+     */
+    static int exec(int argc, char* argv[]);
+
+private slots:
+    void acceptConnections();
+    void onJobChanged(int jobId);
+    void onJobFinished(int jobId, RenderJobState state, const QString& message);
+
+private:
+    QLocalServer* server;
+    RenderQueue* renderQueue;
+    FrameCache frameCache;
+    QHash<int, QPointer<QLocalSocket>> jobClients;  ///< 任务编号 -> 提交该任务的客户端
+    QString lastError;
+
+    void readRequests(QLocalSocket* socket);
+    void handleRequest(QLocalSocket* socket, const QJsonObject& request);
+    void cancelJobsOf(QLocalSocket* socket);
+    static void sendMessage(QLocalSocket* socket, const QJsonObject& message);
+};
+
+#endif // RENDERSERVER_H
@@ -0,0 +1,134 @@
+#include "scratchframe.h"
+
+#include <QtEndian>
+#include <QFileInfo>
+#include <QtConcurrent/QtConcurrentMap>
+#include <stdexcept>
+#include <cstring>
+
+namespace {
+
+/// @brief 压缩格式文件末尾的标识
+const char scratchMagic[4] = {'G', 'M', 'Z', '1'};
+
+/// @brief 压缩级别：1为zlib最快的级别，临时文件只追求减少磁盘读写
+constexpr int compressionLevel = 1;
+
+template <typename T>
+void appendLE(QByteArray& out, T value)
+{
+    value = qToLittleEndian(value);
+    out.append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+} // namespace
+
+void ScratchFrameFile::write(const QString& path, const QImage& frame, ScratchCodec codec)
+{
+    QFile output(path);
+    if (!output.open(QIODevice::WriteOnly)) throw std::runtime_error("无法创建临时文件。");
+
+    if (codec == ScratchCodec::Raw) {
+        if (output.write(reinterpret_cast<const char*>(frame.constBits()), frame.sizeInBytes()) != frame.sizeInBytes()) {
+            throw std::runtime_error("写入临时文件失败，请检查磁盘空间。");
+        }
+    } else {
+        // 各块互不依赖，并行压缩
+        QList<int> blockIndices;
+        for (int i = 0; i < blockCount(frame.height()); ++i) blockIndices.append(i);
+
+        const qsizetype bytesPerLine = frame.bytesPerLine();
+        const QList<QByteArray> blocks = QtConcurrent::blockingMapped(blockIndices, [&frame, bytesPerLine](int block) {
+            const int firstRow = block * blockRows;
+            const int rows = qMin(blockRows, frame.height() - firstRow);
+            return qCompress(frame.constBits() + firstRow * bytesPerLine, rows * bytesPerLine, compressionLevel);
+        });
+
+        QByteArray index;
+        quint64 offset = 0;
+        for (const QByteArray& block : blocks) {
+            if (block.isEmpty()) throw std::runtime_error("压缩临时文件时内存不足。");
+            if (output.write(block) != block.size()) throw std::runtime_error("写入临时文件失败，请检查磁盘空间。");
+            appendLE<quint64>(index, offset);
+            offset += block.size();
+        }
+        appendLE<quint64>(index, offset);
+        appendLE<quint32>(index, quint32(blocks.size()));
+        index.append(scratchMagic, sizeof(scratchMagic));
+        if (output.write(index) != index.size()) throw std::runtime_error("写入临时文件失败，请检查磁盘空间。");
+    }
+
+    output.close();
+    if (output.error() != QFileDevice::NoError) throw std::runtime_error("写入临时文件失败，请检查磁盘空间。");
+}
+
+bool ScratchFrameFile::isComplete(const QString& path, const QSize& frameSize, ScratchCodec codec)
+{
+    if (codec == ScratchCodec::Raw) {
+        return QFileInfo(path).size() == qint64(frameSize.width()) * frameSize.height() * 4;
+    }
+
+    QFile input(path);
+    QList<quint64> offsets;
+    return input.open(QIODevice::ReadOnly) && readIndex(input, blockCount(frameSize.height()), offsets);
+}
+
+bool ScratchFrameFile::open(const QString& path, const QSize& frameSize, ScratchCodec codec)
+{
+    file.setFileName(path);
+    if (!file.open(QIODevice::ReadOnly)) return false;
+
+    if (codec == ScratchCodec::Deflate) return readIndex(file, blockCount(frameSize.height()), blockOffsets);
+
+    // 未压缩的块偏移可以直接推算
+    const quint64 bytesPerLine = quint64(frameSize.width()) * 4;
+    blockOffsets.clear();
+    for (int i = 0; i < blockCount(frameSize.height()); ++i) {
+        blockOffsets.append(quint64(i) * blockRows * bytesPerLine);
+    }
+    blockOffsets.append(quint64(frameSize.height()) * bytesPerLine);
+    return quint64(file.size()) == blockOffsets.last();
+}
+
+bool ScratchFrameFile::readBlock(int blockIndex, QByteArray& buffer)
+{
+    if (blockIndex < 0 || blockIndex + 1 >= blockOffsets.size()) return false;
+    const qint64 begin = qint64(blockOffsets[blockIndex]);
+    const qint64 length = qint64(blockOffsets[blockIndex + 1]) - begin;
+    if (!file.seek(begin)) return false;
+
+    // 缓冲区未被共享时直接复用其内存，不重新分配
+    buffer.resize(length);
+    return file.read(buffer.data(), length) == length;
+}
+
+QByteArray ScratchFrameFile::decodeBlock(const QByteArray& storedBlock, ScratchCodec codec, qsizetype expectedSize)
+{
+    QByteArray rows = (codec == ScratchCodec::Raw) ? storedBlock : qUncompress(storedBlock);
+    return rows.size() == expectedSize ? rows : QByteArray();
+}
+
+bool ScratchFrameFile::readIndex(QFile& file, int expectedBlocks, QList<quint64>& offsets)
+{
+    // 末尾：(块数+1)个偏移、块数、标识
+    const qint64 indexSize = qint64(expectedBlocks + 1) * 8 + 4 + sizeof(scratchMagic);
+    const qint64 fileSize = file.size();
+    if (fileSize < indexSize || !file.seek(fileSize - indexSize)) return false;
+
+    const QByteArray index = file.read(indexSize);
+    if (index.size() != indexSize || memcmp(index.constData() + indexSize - sizeof(scratchMagic), scratchMagic, sizeof(scratchMagic)) != 0) {
+        return false;
+    }
+    if (qFromLittleEndian<quint32>(index.constData() + indexSize - sizeof(scratchMagic) - 4) != quint32(expectedBlocks)) {
+        return false;
+    }
+
+    offsets.clear();
+    for (int i = 0; i <= expectedBlocks; ++i) {
+        const quint64 offset = qFromLittleEndian<quint64>(index.constData() + i * 8);
+        if (!offsets.isEmpty() && offset < offsets.last()) return false;
+        offsets.append(offset);
+    }
+    // 数据必须恰好结束在索引之前
+    return offsets.last() == quint64(fileSize - indexSize);
+}
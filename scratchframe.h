@@ -0,0 +1,68 @@
+#ifndef SCRATCHFRAME_H
+#define SCRATCHFRAME_H
+
+#include <QFile>
+#include <QImage>
+#include <QSize>
+#include <QString>
+#include <QByteArray>
+#include <QList>
+
+/// @brief 阶段一临时帧文件的编码方式。
+enum class ScratchCodec {
+    Raw,        ///< 未压缩的ARGB32像素，按行连续存放
+    Deflate     ///< 按块独立压缩(zlib最快级别)，文件末尾附块索引
+};
+
+/**
+ * @class ScratchFrameFile
+ * @brief 阶段一缩放后的临时帧文件。
+ *
+ * 帧按blockRows行分块，每块可以独立读取和解码，阶段二只读取当前条带所在的块。
+ * 压缩格式的文件布局为：各块的压缩数据、(块数+1)个64位块起始偏移、32位块数、4字节标识。
+ */
+class ScratchFrameFile
+{
+public:
+    /// @brief 每块的行数，与阶段二的条带高度一致，一个条带恰好对应一块。
+    static constexpr int blockRows = 64;
+
+    /**
+     * @brief 将一帧写入临时文件。块的压缩在线程池中并行进行。出错时抛出std::exception。
+     * @param frame ARGB32格式的帧。
+     */
+    static void write(const QString& path, const QImage& frame, ScratchCodec codec);
+
+    /**
+     * @brief 检查临时文件是否完整写入，用于续接时判断能否复用。
+     */
+    static bool isComplete(const QString& path, const QSize& frameSize, ScratchCodec codec);
+
+    /**
+     * @brief 打开临时文件并读取块索引。
+     */
+    bool open(const QString& path, const QSize& frameSize, ScratchCodec codec);
+
+    /**
+     * @brief 将一个块的存储数据(可能是压缩的)读入buffer，buffer的内存在未被共享时复用。
+     * @return 出错时返回false。
+     */
+    bool readBlock(int blockIndex, QByteArray& buffer);
+
+    /**
+     * @brief 将readBlock()读取的数据解码为紧密排列的ARGB32行，可在任意线程中调用。
+     * @return 解码后的行数据；数据损坏时返回空数组。
+     */
+    static QByteArray decodeBlock(const QByteArray& storedBlock, ScratchCodec codec, qsizetype expectedSize);
+
+    /// @brief 帧的块数。
+    static int blockCount(int frameHeight) { return (frameHeight + blockRows - 1) / blockRows; }
+
+private:
+    QFile file;
+    QList<quint64> blockOffsets;    ///< 每块的起始偏移，末尾多一项为数据结束位置
+
+    static bool readIndex(QFile& file, int expectedBlocks, QList<quint64>& offsets);
+};
+
+#endif // SCRATCHFRAME_H
@@ -0,0 +1,102 @@
+#include "frameregistration.h"
+
+#include <QImage>
+#include <QImageIOHandler>
+#include <QImageReader>
+#include <QImageWriter>
+#include <QRandomGenerator>
+#include <QTemporaryDir>
+#include <QTest>
+
+/**
+ * @brief FrameAligner的测试：偏移的坐标轴必须与阶段一按EXIF方向摆正后的画面一致。
+ */
+class TestFrameRegistration : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void offsetsFollowExifOrientation();
+    void alignedRectKeepsTargetAspect();
+
+private:
+    /// @brief 平滑的随机纹理，相位相关有清晰的峰值。
+    static QImage texture(const QSize& size);
+
+    /// @brief 把摆正后的画面按EXIF方向6(需顺时针旋转90度显示)保存为JPEG：像素逆时针旋转后写入，方向只记在元数据中。
+    static bool saveOrientation6(const QImage& oriented, const QString& path);
+};
+
+QImage TestFrameRegistration::texture(const QSize& size)
+{
+    QImage coarse(size.width() / 10, size.height() / 10, QImage::Format_RGB32);
+    QRandomGenerator random(20240601);
+    for (int y = 0; y < coarse.height(); ++y) {
+        for (int x = 0; x < coarse.width(); ++x) {
+            const int v = random.bounded(256);
+            coarse.setPixel(x, y, qRgb(v, v, v));
+        }
+    }
+    return coarse.scaled(size, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+}
+
+bool TestFrameRegistration::saveOrientation6(const QImage& oriented, const QString& path)
+{
+    QImageWriter writer(path, "jpeg");
+    writer.setQuality(95);
+    writer.setTransformation(QImageIOHandler::TransformationRotate90);
+    return writer.write(oriented.transformed(QTransform().rotate(-90)));
+}
+
+void TestFrameRegistration::offsetsFollowExifOrientation()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+
+    // 摆正后的第二帧内容相对第一帧向右移动20像素(宽度的5%)
+    const QImage base = texture(QSize(420, 300));
+    const QString firstPath = dir.filePath("first.jpg");
+    const QString secondPath = dir.filePath("second.jpg");
+    QVERIFY(saveOrientation6(base.copy(20, 0, 400, 300), firstPath));
+    QVERIFY(saveOrientation6(base.copy(0, 0, 400, 300), secondPath));
+
+    QImageReader check(firstPath);
+    if (check.transformation() != QImageIOHandler::TransformationRotate90) {
+        QSKIP("JPEG插件不支持写入EXIF方向信息");
+    }
+    check.setAutoTransform(true);
+    QCOMPARE(check.read().size(), QSize(400, 300));
+
+    const QList<QPointF> offsets = FrameAligner::estimateOffsets({firstPath, secondPath});
+    QCOMPARE(offsets.size(), 2);
+    QVERIFY2(qAbs(offsets[1].x() - 0.05) < 0.01, qPrintable(QString("x = %1").arg(offsets[1].x())));
+    QVERIFY2(qAbs(offsets[1].y()) < 0.01, qPrintable(QString("y = %1").arg(offsets[1].y())));
+
+    // 不摆正时，同一移动出现在文件像素的纵轴上
+    const QList<QPointF> rawOffsets = FrameAligner::estimateOffsets({firstPath, secondPath}, {false, false});
+    QVERIFY2(qAbs(rawOffsets[1].x()) < 0.01, qPrintable(QString("x = %1").arg(rawOffsets[1].x())));
+    QVERIFY2(qAbs(qAbs(rawOffsets[1].y()) - 0.05) < 0.01, qPrintable(QString("y = %1").arg(rawOffsets[1].y())));
+}
+
+void TestFrameRegistration::alignedRectKeepsTargetAspect()
+{
+    // 只有水平方向4%的抖动：共有区域为96% x 100%，裁切为目标的宽高比后不会被横向拉伸
+    const QList<QPointF> offsets = {QPointF(0.0, 0.0), QPointF(0.04, 0.0)};
+    const QSize sourceSize(1000, 500);
+    const QSize targetSize(400, 200);
+    for (int i = 0; i < offsets.size(); ++i) {
+        const QRectF rect = FrameAligner::alignedSourceRect(sourceSize, offsets, i, targetSize);
+        QVERIFY(qAbs(rect.width() / rect.height() - 2.0) < 1e-9);
+        QVERIFY(QRectF(QPointF(0, 0), QSizeF(sourceSize)).contains(rect));
+    }
+
+    // 两帧的区域大小相同，相差的正好是偏移
+    const QRectF first = FrameAligner::alignedSourceRect(sourceSize, offsets, 0, targetSize);
+    const QRectF second = FrameAligner::alignedSourceRect(sourceSize, offsets, 1, targetSize);
+    QCOMPARE(first.size(), second.size());
+    QVERIFY(qAbs(second.x() - first.x() - 40.0) < 1e-9);
+    QVERIFY(qAbs(second.y() - first.y()) < 1e-9);
+}
+
+QTEST_GUILESS_MAIN(TestFrameRegistration)
+#include "tst_frameregistration.moc"
@@ -0,0 +1,69 @@
+#include "interleavegrid.h"
+
+#include <QTest>
+
+/**
+ * @brief InterleaveGrid的测试：自动切片高度得到正方形的透镜单元。
+ */
+class TestInterleaveGrid : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void autoCellsAreSquare_data();
+    void autoCellsAreSquare();
+    void explicitSliceHeightIsKept();
+};
+
+void TestInterleaveGrid::autoCellsAreSquare_data()
+{
+    QTest::addColumn<int>("frameCount");
+    QTest::addColumn<int>("gridColumns");
+    QTest::addColumn<int>("sliceWidth");
+    QTest::addColumn<int>("columns");
+    QTest::addColumn<int>("rows");
+
+    // 5帧、切片宽度1：3 x 2的矩阵切片高度为1.5，取3 x 3
+    QTest::newRow("5帧 宽1") << 5 << 0 << 1 << 3 << 3;
+    QTest::newRow("5帧 宽2") << 5 << 0 << 2 << 3 << 2;
+    QTest::newRow("6帧 宽2") << 6 << 0 << 2 << 3 << 2;
+    QTest::newRow("4帧 宽1") << 4 << 0 << 1 << 2 << 2;
+    QTest::newRow("7帧 宽4") << 7 << 0 << 4 << 3 << 3;
+    QTest::newRow("12帧 宽3") << 12 << 0 << 3 << 4 << 3;
+    QTest::newRow("指定4列 5帧 宽1") << 5 << 4 << 1 << 4 << 2;
+}
+
+void TestInterleaveGrid::autoCellsAreSquare()
+{
+    QFETCH(int, frameCount);
+    QFETCH(int, gridColumns);
+    QFETCH(int, sliceWidth);
+    QFETCH(int, columns);
+    QFETCH(int, rows);
+
+    const InterleaveGrid grid = InterleaveGrid::resolve(frameCount, gridColumns, sliceWidth, 0);
+    QCOMPARE(grid.columns, columns);
+    QCOMPARE(grid.rows, rows);
+    QVERIFY(grid.columns * grid.rows >= frameCount);
+    QVERIFY(grid.isSquare(sliceWidth));
+    const QSize cell = grid.cellSize(sliceWidth);
+    QCOMPARE(cell.width(), cell.height());
+}
+
+void TestInterleaveGrid::explicitSliceHeightIsKept()
+{
+    // 手动指定的切片高度不调整，做不到正方形时由isSquare()报告
+    const InterleaveGrid grid = InterleaveGrid::resolve(5, 0, 1, 1);
+    QCOMPARE(grid.rows, 2);
+    QCOMPARE(grid.sliceHeight, 1);
+    QVERIFY(!grid.isSquare(1));
+
+    // 指定的列数少于所需行数且单元宽度不能被行数整除时，取最接近的高度
+    const InterleaveGrid narrow = InterleaveGrid::resolve(9, 2, 1, 0);
+    QCOMPARE(narrow.rows, 5);
+    QCOMPARE(narrow.sliceHeight, 1);
+    QVERIFY(!narrow.isSquare(1));
+}
+
+QTEST_GUILESS_MAIN(TestInterleaveGrid)
+#include "tst_interleavegrid.moc"
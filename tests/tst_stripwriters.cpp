@@ -0,0 +1,203 @@
+#include "tiffwriter.h"
+#include "pdfwriter.h"
+
+#include <QFile>
+#include <QImage>
+#include <QImageReader>
+#include <QRegularExpression>
+#include <QTemporaryDir>
+#include <QTest>
+#include <QtEndian>
+#include <cstring>
+
+/**
+ * @brief TiffStripWriter和PdfStripWriter的测试：suspend()之后从检查点resume()，写完的文件与一次写完的内容相同。
+ */
+class TestStripWriters : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void tiffResumesAfterSuspend();
+    void tiffRejectsMismatchedResume();
+    void pdfResumesAfterSuspend();
+    void pdfRejectsResumeOffBandBoundary();
+
+private:
+    /// @brief 宽度为奇数、高度不是条带整数倍的测试图像，每个像素的颜色由坐标决定。
+    static QImage pattern();
+
+    /// @brief 按渲染时的方式每64行写一个条带，从firstRow开始，写到lastRow为止。
+    template <typename Writer>
+    static bool writeRows(Writer& writer, const QImage& image, int firstRow, int lastRow);
+
+    static constexpr int bandRows = 64;
+    static constexpr double dpi = 300.0;
+};
+
+QImage TestStripWriters::pattern()
+{
+    QImage image(37, 150, QImage::Format_ARGB32);
+    for (int y = 0; y < image.height(); ++y) {
+        for (int x = 0; x < image.width(); ++x) {
+            image.setPixel(x, y, qRgb((x * 7) & 0xff, (y * 3) & 0xff, (x * y) & 0xff));
+        }
+    }
+    return image;
+}
+
+template <typename Writer>
+bool TestStripWriters::writeRows(Writer& writer, const QImage& image, int firstRow, int lastRow)
+{
+    for (int y = firstRow; y < lastRow; y += bandRows) {
+        if (!writer.writeBand(image.copy(0, y, image.width(), qMin(bandRows, lastRow - y)))) return false;
+    }
+    return writer.flush();
+}
+
+void TestStripWriters::tiffResumesAfterSuspend()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString path = dir.filePath("result.tif");
+    const QImage image = pattern();
+
+    // 写完两个条带后中断，检查点只记录了第一个条带：续接时截掉第二个条带，从第64行重新写
+    {
+        TiffStripWriter writer;
+        QVERIFY(writer.open(path, image.size(), TiffStripWriter::ColorModel::Rgb, dpi));
+        QVERIFY(writeRows(writer, image, 0, 2 * bandRows));
+        writer.suspend();
+    }
+    QVERIFY(QFile::exists(path));
+
+    TiffStripWriter writer;
+    QVERIFY2(writer.resume(path, image.size(), TiffStripWriter::ColorModel::Rgb, dpi, QByteArray(), bandRows),
+             qPrintable(writer.errorString()));
+    QVERIFY(writeRows(writer, image, bandRows, image.height()));
+    QVERIFY2(writer.close(), qPrintable(writer.errorString()));
+
+    if (!QImageReader::supportedImageFormats().contains("tiff")) QSKIP("没有可用的TIFF图像插件。");
+    QImageReader reader(path, "tiff");
+    const QImage written = reader.read();
+    QVERIFY2(!written.isNull(), qPrintable(reader.errorString()));
+    QCOMPARE(written.size(), image.size());
+    QCOMPARE(written.convertToFormat(QImage::Format_RGB32), image.convertToFormat(QImage::Format_RGB32));
+    QCOMPARE(qRound(written.dotsPerMeterX() * 0.0254), qRound(dpi));
+}
+
+void TestStripWriters::tiffRejectsMismatchedResume()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString path = dir.filePath("result.tif");
+    const QImage image = pattern();
+    {
+        TiffStripWriter writer;
+        QVERIFY(writer.open(path, image.size(), TiffStripWriter::ColorModel::Rgb, dpi));
+        QVERIFY(writeRows(writer, image, 0, bandRows));
+        writer.suspend();
+    }
+
+    // 文件头与参数不符，或检查点记录的行超出文件中的数据时不能续接
+    TiffStripWriter writer;
+    QVERIFY(!writer.resume(path, QSize(image.width() + 1, image.height()), TiffStripWriter::ColorModel::Rgb,
+                           dpi, QByteArray(), bandRows));
+    QVERIFY(!writer.resume(path, image.size(), TiffStripWriter::ColorModel::Rgb, dpi, QByteArray(), 2 * bandRows));
+    writer.suspend();
+    QVERIFY(QFile::exists(path));
+}
+
+void TestStripWriters::pdfResumesAfterSuspend()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString path = dir.filePath("result.pdf");
+    const QImage image = pattern();
+
+    {
+        PdfStripWriter writer;
+        QVERIFY(writer.open(path, image.size(), PdfStripWriter::ColorModel::Rgb, dpi));
+        QVERIFY(writeRows(writer, image, 0, 2 * bandRows));
+        writer.suspend();
+    }
+
+    PdfStripWriter writer;
+    QVERIFY2(writer.resume(path, image.size(), PdfStripWriter::ColorModel::Rgb, dpi, QByteArray(), bandRows),
+             qPrintable(writer.errorString()));
+    QVERIFY(writeRows(writer, image, bandRows, image.height()));
+    QVERIFY2(writer.close(), qPrintable(writer.errorString()));
+
+    QFile file(path);
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    const QByteArray pdf = file.readAll();
+
+    // 对象：ICC配置文件(此处为空)、3个条带、内容流、页面、页面树、目录；另加固定的空闲对象0
+    const int bandCount = (image.height() + bandRows - 1) / bandRows;
+    const int objectCount = 1 + 1 + bandCount + 4;
+    const QRegularExpressionMatch startxref = QRegularExpression("startxref\n(\\d+)\n%%EOF\n$").match(QString::fromLatin1(pdf));
+    QVERIFY(startxref.hasMatch());
+    const qsizetype xrefOffset = startxref.captured(1).toLongLong();
+    const QByteArray xrefHead = "xref\n0 " + QByteArray::number(objectCount) + "\n0000000000 65535 f \n";
+    QCOMPARE(pdf.mid(xrefOffset, xrefHead.size()), xrefHead);
+    QVERIFY(pdf.contains("trailer\n<< /Size " + QByteArray::number(objectCount) + " "));
+
+    // 交叉引用表的每一项都必须正好指向对应对象的开头
+    QList<qsizetype> objectOffsets{0};
+    for (int object = 1; object < objectCount; ++object) {
+        const QByteArray entry = pdf.mid(xrefOffset + xrefHead.size() + (object - 1) * 20, 20);
+        QVERIFY(entry.endsWith(" 00000 n \n"));
+        const qsizetype offset = entry.left(10).toLongLong();
+        QCOMPARE(pdf.mid(offset, QByteArray::number(object).size() + 7), QByteArray::number(object) + " 0 obj\n");
+        objectOffsets.append(offset);
+    }
+
+    // 续接后的条带依次衔接，解压后与原图的各行一致
+    const QImage rgb = image.convertToFormat(QImage::Format_RGB888);
+    const qsizetype rowBytes = qsizetype(image.width()) * 3;
+    int top = 0;
+    for (int band = 0; band < bandCount; ++band) {
+        const qsizetype start = objectOffsets[2 + band];
+        const QRegularExpressionMatch dictionary = QRegularExpression("/Height (\\d+) .*/Length (\\d+) >>\nstream\n")
+                                                       .match(QString::fromLatin1(pdf.mid(start, 512)));
+        QVERIFY(dictionary.hasMatch());
+        const int rows = dictionary.captured(1).toInt();
+        QCOMPARE(rows, qMin(bandRows, image.height() - top));
+
+        const qsizetype dataStart = start + pdf.mid(start, 512).indexOf(">>\nstream\n") + 10;
+        QByteArray compressed(4, '\0');
+        qToBigEndian<quint32>(quint32(rows * rowBytes), compressed.data());
+        compressed += pdf.mid(dataStart, dictionary.captured(2).toLongLong());
+        const QByteArray decoded = qUncompress(compressed);
+        QCOMPARE(decoded.size(), rows * rowBytes);
+        for (int y = 0; y < rows; ++y) {
+            QVERIFY(memcmp(decoded.constData() + y * rowBytes, rgb.constScanLine(top + y), rowBytes) == 0);
+        }
+        top += rows;
+    }
+    QCOMPARE(top, image.height());
+}
+
+void TestStripWriters::pdfRejectsResumeOffBandBoundary()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString path = dir.filePath("result.pdf");
+    const QImage image = pattern();
+    {
+        PdfStripWriter writer;
+        QVERIFY(writer.open(path, image.size(), PdfStripWriter::ColorModel::Rgb, dpi));
+        QVERIFY(writeRows(writer, image, 0, 2 * bandRows));
+        writer.suspend();
+    }
+
+    // PDF的条带是独立压缩的对象，续接点只能落在条带边界上
+    PdfStripWriter writer;
+    QVERIFY(!writer.resume(path, image.size(), PdfStripWriter::ColorModel::Rgb, dpi, QByteArray(), bandRows / 2));
+    writer.suspend();
+    QVERIFY(writer.resume(path, image.size(), PdfStripWriter::ColorModel::Rgb, dpi, QByteArray(), 2 * bandRows));
+    writer.suspend();
+}
+
+QTEST_GUILESS_MAIN(TestStripWriters)
+#include "tst_stripwriters.moc"
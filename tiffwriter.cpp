@@ -0,0 +1,312 @@
+#include "tiffwriter.h"
+
+#include <QList>
+#include <QtEndian>
+#include <cmath>
+
+namespace {
+
+// TIFF字段类型
+constexpr quint16 TypeShort = 3;
+constexpr quint16 TypeLong = 4;
+constexpr quint16 TypeRational = 5;
+constexpr quint16 TypeUndefined = 7;
+constexpr quint16 TypeLong8 = 16;
+
+struct TiffEntry {
+    quint16 tag;
+    quint16 type;
+    quint64 count;
+    QByteArray data; // 已按小端序编码的字段值
+};
+
+template <typename T>
+void appendLE(QByteArray& out, T value)
+{
+    value = qToLittleEndian(value);
+    out.append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+TiffEntry shortEntry(quint16 tag, const QList<quint16>& values)
+{
+    TiffEntry entry{tag, TypeShort, quint64(values.size()), QByteArray()};
+    for (quint16 value : values) appendLE<quint16>(entry.data, value);
+    return entry;
+}
+
+TiffEntry longEntry(quint16 tag, quint32 value)
+{
+    TiffEntry entry{tag, TypeLong, 1, QByteArray()};
+    appendLE<quint32>(entry.data, value);
+    return entry;
+}
+
+TiffEntry rationalEntry(quint16 tag, double value)
+{
+    TiffEntry entry{tag, TypeRational, 1, QByteArray()};
+    appendLE<quint32>(entry.data, static_cast<quint32>(std::round(value * 100.0)));
+    appendLE<quint32>(entry.data, 100);
+    return entry;
+}
+
+} // namespace
+
+TiffStripWriter::~TiffStripWriter()
+{
+    // 未正常close()的文件是不完整的，直接丢弃
+    if (file.isOpen()) abort();
+}
+
+void TiffStripWriter::prepare(const QSize& imageSize, ColorModel colorModel, double dpi, const QByteArray& iccProfile)
+{
+    size = imageSize;
+    model = colorModel;
+    resolutionDpi = dpi > 0.0 ? dpi : 72.0;
+    embeddedProfile = iccProfile;
+    samplesPerPixel = (model == ColorModel::Cmyk) ? 4 : 3;
+    rowsWritten = 0;
+    lastError.clear();
+
+    // 像素数据加上目录和ICC数据超出经典TIFF的32位偏移范围时，改用BigTIFF
+    const quint64 stripCount = (size.height() + rowsPerStrip - 1) / rowsPerStrip;
+    const quint64 dataBytes = quint64(size.width()) * samplesPerPixel * size.height();
+    const quint64 estimatedFileSize = dataBytes + quint64(embeddedProfile.size()) + stripCount * 16 + 4096;
+    bigTiff = estimatedFileSize >= 0xFFFFFFFFull;
+}
+
+QByteArray TiffStripWriter::buildHeader() const
+{
+    // 文件头中的目录偏移先写0，close()时回填
+    QByteArray header("II", 2);
+    if (bigTiff) {
+        appendLE<quint16>(header, 43);
+        appendLE<quint16>(header, 8);
+        appendLE<quint16>(header, 0);
+        appendLE<quint64>(header, 0);
+    } else {
+        appendLE<quint16>(header, 42);
+        appendLE<quint32>(header, 0);
+    }
+    return header;
+}
+
+bool TiffStripWriter::open(const QString& path, const QSize& imageSize, ColorModel colorModel, double dpi, const QByteArray& iccProfile)
+{
+    prepare(imageSize, colorModel, dpi, iccProfile);
+    if (size.isEmpty()) return fail("TIFF图像尺寸无效。");
+
+    file.setFileName(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        return fail(QString("无法创建输出文件: %1").arg(file.errorString()));
+    }
+
+    const QByteArray header = buildHeader();
+    if (file.write(header) != header.size()) {
+        return fail(QString("写入TIFF文件头失败: %1").arg(file.errorString()));
+    }
+    return true;
+}
+
+bool TiffStripWriter::resume(const QString& path, const QSize& imageSize, ColorModel colorModel, double dpi,
+                             const QByteArray& iccProfile, int completedRows)
+{
+    prepare(imageSize, colorModel, dpi, iccProfile);
+    if (size.isEmpty() || completedRows < 0 || completedRows > size.height()) return fail("TIFF图像尺寸无效。");
+
+    file.setFileName(path);
+    if (!file.open(QIODevice::ReadWrite)) {
+        return fail(QString("无法打开未完成的输出文件: %1").arg(file.errorString()));
+    }
+
+    // 文件头必须与本次参数推算的一致，且已写入的行必须完整
+    const QByteArray header = buildHeader();
+    const qint64 validSize = header.size() + qint64(completedRows) * size.width() * samplesPerPixel;
+    if (file.read(header.size()) != header || file.size() < validSize) {
+        file.close();
+        return fail("未完成的输出文件与当前任务不匹配。");
+    }
+    if (!file.resize(validSize) || !file.seek(validSize)) {
+        file.close();
+        return fail(QString("无法截断未完成的输出文件: %1").arg(file.errorString()));
+    }
+    rowsWritten = completedRows;
+    return true;
+}
+
+bool TiffStripWriter::writeBand(const QImage& band)
+{
+    if (!file.isOpen()) return fail("TIFF文件未打开。");
+    if (band.width() != size.width() || rowsWritten + band.height() > size.height()) {
+        return fail("条带尺寸与TIFF图像尺寸不匹配。");
+    }
+
+    QImage rows;
+    if (model == ColorModel::Cmyk) {
+        if (band.format() != QImage::Format_CMYK8888) return fail("CMYK输出需要CMYK8888格式的条带。");
+        rows = band;
+    } else {
+        rows = band.convertToFormat(QImage::Format_RGB888);
+        if (rows.isNull()) return fail("转换条带格式时内存不足。");
+    }
+
+    const qint64 rowBytes = qint64(size.width()) * samplesPerPixel;
+    for (int y = 0; y < rows.height(); ++y) {
+        if (file.write(reinterpret_cast<const char*>(rows.constScanLine(y)), rowBytes) != rowBytes) {
+            return fail(QString("写入TIFF数据失败: %1").arg(file.errorString()));
+        }
+    }
+    rowsWritten += rows.height();
+    return true;
+}
+
+bool TiffStripWriter::flush()
+{
+    if (!file.isOpen()) return fail("TIFF文件未打开。");
+    if (!file.flush()) return fail(QString("写入TIFF数据失败: %1").arg(file.errorString()));
+    return true;
+}
+
+bool TiffStripWriter::close()
+{
+    if (!file.isOpen()) return fail("TIFF文件未打开。");
+    if (rowsWritten != size.height()) return fail("TIFF数据不完整，无法结束写入。");
+
+    const quint64 dataOffset = bigTiff ? 16 : 8;
+
+    // 目录紧跟在像素数据之后，按8字节对齐
+    quint64 directoryOffset = quint64(file.pos());
+    const int padding = int((8 - directoryOffset % 8) % 8);
+    if (padding > 0) {
+        file.write(QByteArray(padding, '\0'));
+        directoryOffset += padding;
+    }
+
+    const QByteArray directory = buildDirectory(directoryOffset, dataOffset);
+    if (file.write(directory) != directory.size()) {
+        return fail(QString("写入TIFF目录失败: %1").arg(file.errorString()));
+    }
+
+    // 回填文件头中的目录偏移
+    QByteArray offsetBytes;
+    if (bigTiff) {
+        appendLE<quint64>(offsetBytes, directoryOffset);
+    } else {
+        appendLE<quint32>(offsetBytes, quint32(directoryOffset));
+    }
+    if (!file.seek(bigTiff ? 8 : 4) || file.write(offsetBytes) != offsetBytes.size()) {
+        return fail(QString("写入TIFF文件头失败: %1").arg(file.errorString()));
+    }
+
+    file.close();
+    if (file.error() != QFileDevice::NoError) {
+        return fail(QString("关闭TIFF文件失败: %1").arg(file.errorString()));
+    }
+    return true;
+}
+
+void TiffStripWriter::abort()
+{
+    if (file.isOpen()) file.close();
+    file.remove();
+}
+
+void TiffStripWriter::suspend()
+{
+    if (file.isOpen()) file.close();
+}
+
+bool TiffStripWriter::fail(const QString& message)
+{
+    lastError = message;
+    return false;
+}
+
+QByteArray TiffStripWriter::buildDirectory(quint64 directoryOffset, quint64 dataOffset) const
+{
+    const quint64 rowBytes = quint64(size.width()) * samplesPerPixel;
+    const int stripCount = (size.height() + rowsPerStrip - 1) / rowsPerStrip;
+
+    // 数据未压缩且按行连续存放，每个条带的偏移和长度都可以直接推算
+    TiffEntry stripOffsets{273, bigTiff ? TypeLong8 : TypeLong, quint64(stripCount), QByteArray()};
+    TiffEntry stripByteCounts{279, TypeLong, quint64(stripCount), QByteArray()};
+    for (int i = 0; i < stripCount; ++i) {
+        const quint64 firstRow = quint64(i) * rowsPerStrip;
+        const quint64 rows = qMin<quint64>(rowsPerStrip, size.height() - firstRow);
+        const quint64 offset = dataOffset + firstRow * rowBytes;
+        if (bigTiff) {
+            appendLE<quint64>(stripOffsets.data, offset);
+        } else {
+            appendLE<quint32>(stripOffsets.data, quint32(offset));
+        }
+        appendLE<quint32>(stripByteCounts.data, quint32(rows * rowBytes));
+    }
+
+    // 字段必须按标签号升序排列
+    QList<TiffEntry> entries;
+    entries.append(longEntry(256, size.width()));                                   // ImageWidth
+    entries.append(longEntry(257, size.height()));                                  // ImageLength
+    entries.append(shortEntry(258, QList<quint16>(samplesPerPixel, 8)));            // BitsPerSample
+    entries.append(shortEntry(259, {1}));                                           // Compression: 无
+    entries.append(shortEntry(262, {quint16(model == ColorModel::Cmyk ? 5 : 2)}));  // Photometric: 分色/RGB
+    entries.append(stripOffsets);                                                   // StripOffsets
+    entries.append(shortEntry(277, {quint16(samplesPerPixel)}));                    // SamplesPerPixel
+    entries.append(longEntry(278, rowsPerStrip));                                   // RowsPerStrip
+    entries.append(stripByteCounts);                                                // StripByteCounts
+    entries.append(rationalEntry(282, resolutionDpi));                              // XResolution
+    entries.append(rationalEntry(283, resolutionDpi));                              // YResolution
+    entries.append(shortEntry(284, {1}));                                           // PlanarConfiguration: 交错存放
+    entries.append(shortEntry(296, {2}));                                           // ResolutionUnit: 英寸
+    if (model == ColorModel::Cmyk) {
+        entries.append(shortEntry(332, {1}));                                       // InkSet: CMYK
+    }
+    if (!embeddedProfile.isEmpty()) {
+        entries.append(TiffEntry{34675, TypeUndefined, quint64(embeddedProfile.size()), embeddedProfile}); // ICC配置文件
+    }
+
+    const int inlineSize = bigTiff ? 8 : 4;
+    const quint64 countSize = bigTiff ? 8 : 2;
+    const quint64 entrySize = bigTiff ? 20 : 12;
+    const quint64 nextOffsetSize = bigTiff ? 8 : 4;
+    const quint64 externalOffset = directoryOffset + countSize + entries.size() * entrySize + nextOffsetSize;
+
+    QByteArray directory;
+    QByteArray external; // 放不进字段本身的值，紧跟在目录之后
+    if (bigTiff) {
+        appendLE<quint64>(directory, entries.size());
+    } else {
+        appendLE<quint16>(directory, quint16(entries.size()));
+    }
+
+    for (const TiffEntry& entry : entries) {
+        appendLE<quint16>(directory, entry.tag);
+        appendLE<quint16>(directory, entry.type);
+        if (bigTiff) {
+            appendLE<quint64>(directory, entry.count);
+        } else {
+            appendLE<quint32>(directory, quint32(entry.count));
+        }
+
+        if (entry.data.size() <= inlineSize) {
+            directory.append(entry.data);
+            directory.append(QByteArray(inlineSize - entry.data.size(), '\0'));
+        } else {
+            const quint64 valueOffset = externalOffset + external.size();
+            if (bigTiff) {
+                appendLE<quint64>(directory, valueOffset);
+            } else {
+                appendLE<quint32>(directory, quint32(valueOffset));
+            }
+            external.append(entry.data);
+            if (external.size() % 2) external.append('\0');
+        }
+    }
+
+    // 只有一个目录
+    if (bigTiff) {
+        appendLE<quint64>(directory, 0);
+    } else {
+        appendLE<quint32>(directory, 0);
+    }
+
+    return directory + external;
+}
@@ -0,0 +1,94 @@
+#ifndef TIFFWRITER_H
+#define TIFFWRITER_H
+
+#include <QFile>
+#include <QImage>
+#include <QSize>
+#include <QString>
+#include <QByteArray>
+
+/**
+ * @class TiffStripWriter
+ * @brief 以条带为单位流式写出未压缩TIFF文件，整幅图像无需同时驻留内存。
+ *
+ * 像素数据按行顺序追加写入文件，文件目录(IFD)在close()时写在数据之后。
+ * 数据量超过经典TIFF的4GB上限时自动改用BigTIFF格式。
+ */
+class TiffStripWriter
+{
+public:
+    /// @brief 输出文件的颜色模型。
+    enum class ColorModel {
+        Rgb,    ///< 8位RGB，接受ARGB32/RGB32条带
+        Cmyk    ///< 8位CMYK(分色)，接受CMYK8888条带
+    };
+
+    TiffStripWriter() = default;
+    ~TiffStripWriter();
+
+    /**
+     * @brief 创建输出文件并写入文件头。
+     * @param path 输出文件路径。
+     * @param imageSize 整幅图像的像素尺寸。
+     * @param colorModel 颜色模型。
+     * @param dpi 写入文件的物理分辨率。
+     * @param iccProfile 嵌入文件的ICC配置文件，可为空。
+     */
+    bool open(const QString& path, const QSize& imageSize, ColorModel colorModel, double dpi, const QByteArray& iccProfile = QByteArray());
+
+    /**
+     * @brief 重新打开之前suspend()的未完成文件，从completedRows行之后继续写入。
+     * 参数须与最初open()时一致；文件中超出completedRows的数据会被截掉。
+     */
+    bool resume(const QString& path, const QSize& imageSize, ColorModel colorModel, double dpi,
+                const QByteArray& iccProfile, int completedRows);
+
+    /**
+     * @brief 按顺序追加一个条带(若干完整的行)。
+     * @param band 宽度必须与图像一致；格式需与颜色模型匹配。
+     */
+    bool writeBand(const QImage& band);
+
+    /**
+     * @brief 将已写入的数据交给操作系统，之后即使程序退出这些行也不会丢失。
+     */
+    bool flush();
+
+    /**
+     * @brief 写入文件目录并关闭文件。所有行都必须已写入。
+     */
+    bool close();
+
+    /**
+     * @brief 放弃写入并删除未完成的文件。
+     */
+    void abort();
+
+    /**
+     * @brief 关闭未完成的文件但保留已写入的数据，以便之后用resume()继续。
+     */
+    void suspend();
+
+    QString errorString() const { return lastError; }
+
+private:
+    QFile file;
+    QSize size;
+    ColorModel model = ColorModel::Rgb;
+    double resolutionDpi = 0.0;
+    QByteArray embeddedProfile;
+    bool bigTiff = false;
+    int samplesPerPixel = 3;
+    int rowsWritten = 0;
+    QString lastError;
+
+    /// @brief 每个TIFF条带包含的行数。数据未压缩，因此条带偏移可直接推算。
+    static constexpr int rowsPerStrip = 64;
+
+    bool fail(const QString& message);
+    void prepare(const QSize& imageSize, ColorModel colorModel, double dpi, const QByteArray& iccProfile);
+    QByteArray buildHeader() const;
+    QByteArray buildDirectory(quint64 directoryOffset, quint64 dataOffset) const;
+};
+
+#endif // TIFFWRITER_H